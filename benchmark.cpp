@@ -0,0 +1,107 @@
+#include <SDL3/SDL.h>
+
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "json.hpp"
+#include "stats.hpp"
+
+const std::vector<BenchmarkView>& GetBenchmarkViews()
+{
+    static const std::vector<BenchmarkView> views =
+    {
+        {"default", 0.0f, 0.0f, 1.0e11f},
+        {"wide", 0.3f, 0.0f, 3.0e11f},
+        {"edge", 0.02f, 1.0f, 6.0e10f},
+        {"above", 1.5f, 0.0f, 1.0e11f},
+        {"photon_ring", 0.1f, 0.5f, 3.0e10f},
+    };
+    return views;
+}
+
+bool SaveBenchmark(const std::string_view& path, const std::vector<BenchmarkResult>& results)
+{
+    nlohmann::json json;
+    for (const BenchmarkResult& result : results)
+    {
+        nlohmann::json& entry = json["views"][result.Name];
+        entry["count"] = result.Stats.Count();
+        entry["mean"] = result.Stats.Mean();
+        entry["stddev"] = result.Stats.Stddev();
+        entry["ci95"] = result.Stats.Ci95();
+        entry["samples"] = result.Stats.Samples;
+    }
+    std::ofstream file(std::string(path), std::ios::binary);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open benchmark: %s", std::string(path).data());
+        return false;
+    }
+    file << json.dump(4);
+    return true;
+}
+
+bool CompareBenchmark(const std::string_view& path, const std::vector<BenchmarkResult>& results, double threshold, bool* regressed)
+{
+    *regressed = false;
+    std::ifstream file(std::string(path), std::ios::binary);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open baseline: %s", std::string(path).data());
+        return false;
+    }
+    nlohmann::json json;
+    try
+    {
+        file >> json;
+    }
+    catch (const std::exception& exception)
+    {
+        SDL_Log("Failed to parse baseline: %s, %s", std::string(path).data(), exception.what());
+        return false;
+    }
+    for (const BenchmarkResult& result : results)
+    {
+        if (!json["views"].contains(result.Name))
+        {
+            SDL_Log("%s: missing from baseline", result.Name.data());
+            continue;
+        }
+        const nlohmann::json& entry = json["views"][result.Name];
+        double baseMean = entry["mean"];
+        double baseStddev = entry["stddev"];
+        size_t baseCount = entry["count"];
+        double mean = result.Stats.Mean();
+        double stddev = result.Stats.Stddev();
+        size_t count = result.Stats.Count();
+        if (baseMean <= 0.0 || baseCount < 2 || count < 2)
+        {
+            SDL_Log("%s: not enough samples to compare", result.Name.data());
+            continue;
+        }
+        /* NOTE: Welch's t-test so differing variances between runs don't produce false alarms */
+        double error = std::sqrt(stddev * stddev / count + baseStddev * baseStddev / baseCount);
+        double t = error > 0.0 ? (mean - baseMean) / error : 0.0;
+        bool significant = std::abs(t) > TCritical95(WelchDf(stddev, count, baseStddev, baseCount));
+        double change = (mean - baseMean) / baseMean * 100.0;
+        const char* verdict = "unchanged";
+        if (significant && change > threshold)
+        {
+            verdict = "REGRESSION";
+            *regressed = true;
+        }
+        else if (significant && change < -threshold)
+        {
+            verdict = "improvement";
+        }
+        SDL_Log("%s: %.3fms +/- %.3f vs %.3fms +/- %.3f (%+.1f%%, t=%.2f) %s",
+            result.Name.data(), mean, result.Stats.Ci95(), baseMean,
+            entry.value("ci95", 0.0), change, t, verdict);
+    }
+    return true;
+}
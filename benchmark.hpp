@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stats.hpp"
+
+struct BenchmarkView
+{
+    const char* Name;
+    float Pitch;
+    float Yaw;
+    float Distance;
+};
+
+struct BenchmarkResult
+{
+    std::string Name;
+    FrameStats Stats;
+};
+
+const std::vector<BenchmarkView>& GetBenchmarkViews();
+bool SaveBenchmark(const std::string_view& path, const std::vector<BenchmarkResult>& results);
+bool CompareBenchmark(const std::string_view& path, const std::vector<BenchmarkResult>& results, double threshold, bool* regressed);
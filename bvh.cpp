@@ -0,0 +1,285 @@
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "bvh.hpp"
+#include "config.h"
+#include "scene.hpp"
+
+static constexpr int kBins = 12;
+static constexpr uint32_t kLeafSize = 4;
+static constexpr float kTraversalCost = 1.0f;
+
+struct Bounds
+{
+    glm::vec3 Min{std::numeric_limits<float>::max()};
+    glm::vec3 Max{-std::numeric_limits<float>::max()};
+
+    void Grow(const glm::vec3& min, const glm::vec3& max)
+    {
+        Min = glm::min(Min, min);
+        Max = glm::max(Max, max);
+    }
+
+    void Grow(const Bounds& bounds)
+    {
+        Grow(bounds.Min, bounds.Max);
+    }
+
+    float Area() const
+    {
+        glm::vec3 extent = Max - Min;
+        if (extent.x < 0.0f)
+        {
+            return 0.0f;
+        }
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+};
+
+/* NOTE: what the builder reads of an object, partitioned in place so every pass is sequential */
+struct Primitive
+{
+    glm::vec3 Position;
+    float Radius;
+    uint32_t Index;
+};
+
+struct Builder
+{
+    std::vector<Primitive> Primitives;
+    std::vector<BvhNode>& Nodes;
+};
+
+template <typename T>
+static Bounds GetBounds(const T& object)
+{
+    Bounds bounds;
+    bounds.Grow(object.Position - glm::vec3(object.Radius), object.Position + glm::vec3(object.Radius));
+    return bounds;
+}
+
+static void Build(Builder& builder, uint32_t begin, uint32_t end, int depth)
+{
+    uint32_t index = builder.Nodes.size();
+    builder.Nodes.emplace_back();
+    Bounds bounds;
+    Bounds centers;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        const Primitive& object = builder.Primitives[i];
+        bounds.Grow(GetBounds(object));
+        centers.Grow(object.Position, object.Position);
+    }
+    uint32_t count = end - begin;
+    auto makeLeaf = [&]()
+    {
+        BvhNode& node = builder.Nodes[index];
+        node.Min = bounds.Min;
+        node.Max = bounds.Max;
+        node.Offset = begin;
+        node.Count = count;
+    };
+    if (count <= 1 || depth >= BVH_STACK - 1)
+    {
+        makeLeaf();
+        return;
+    }
+    /* NOTE: binned surface area heuristic over centroids */
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+    for (int axis = 0; axis < 3; axis++)
+    {
+        float min = centers.Min[axis];
+        float max = centers.Max[axis];
+        if (max <= min)
+        {
+            continue;
+        }
+        std::array<Bounds, kBins> bins;
+        std::array<uint32_t, kBins> binCounts{};
+        float scale = kBins / (max - min);
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const Primitive& object = builder.Primitives[i];
+            int bin = std::min(kBins - 1, int((object.Position[axis] - min) * scale));
+            bins[bin].Grow(GetBounds(object));
+            binCounts[bin]++;
+        }
+        std::array<float, kBins - 1> leftAreas;
+        std::array<uint32_t, kBins - 1> leftCounts;
+        Bounds left;
+        uint32_t leftCount = 0;
+        for (int i = 0; i < kBins - 1; i++)
+        {
+            left.Grow(bins[i]);
+            leftCount += binCounts[i];
+            leftAreas[i] = left.Area();
+            leftCounts[i] = leftCount;
+        }
+        Bounds right;
+        uint32_t rightCount = 0;
+        for (int i = kBins - 1; i > 0; i--)
+        {
+            right.Grow(bins[i]);
+            rightCount += binCounts[i];
+            if (!leftCounts[i - 1] || !rightCount)
+            {
+                continue;
+            }
+            float cost = leftAreas[i - 1] * leftCounts[i - 1] + right.Area() * rightCount;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+    float area = bounds.Area();
+    float leafCost = float(count);
+    float splitCost = area > 0.0f ? kTraversalCost + bestCost / area : leafCost;
+    if (count <= kLeafSize && leafCost <= splitCost)
+    {
+        makeLeaf();
+        return;
+    }
+    Primitive* first = builder.Primitives.data() + begin;
+    Primitive* last = builder.Primitives.data() + end;
+    Primitive* middle;
+    if (bestAxis >= 0)
+    {
+        float min = centers.Min[bestAxis];
+        float scale = kBins / (centers.Max[bestAxis] - min);
+        middle = std::partition(first, last, [&](const Primitive& primitive)
+        {
+            return std::min(kBins - 1, int((primitive.Position[bestAxis] - min) * scale)) < bestSplit;
+        });
+    }
+    else
+    {
+        /* NOTE: coincident centroids, split by index */
+        middle = first + count / 2;
+    }
+    uint32_t split = middle - builder.Primitives.data();
+    Build(builder, begin, split, depth + 1);
+    uint32_t right = builder.Nodes.size();
+    Build(builder, split, end, depth + 1);
+    BvhNode& node = builder.Nodes[index];
+    node.Min = bounds.Min;
+    node.Max = bounds.Max;
+    node.Offset = right;
+    node.Count = 0;
+}
+
+void BuildBvh(std::span<const Object> objects, std::vector<BvhNode>& nodes, std::vector<uint32_t>& indices)
+{
+    nodes.clear();
+    indices.resize(objects.size());
+    if (objects.empty())
+    {
+        BvhNode& node = nodes.emplace_back();
+        node.Min = glm::vec3(0.0f);
+        node.Max = glm::vec3(0.0f);
+        node.Offset = 0;
+        node.Count = 0;
+        return;
+    }
+    nodes.reserve(objects.size() * 2);
+    Builder builder{{}, nodes};
+    builder.Primitives.resize(objects.size());
+    for (uint32_t i = 0; i < objects.size(); i++)
+    {
+        builder.Primitives[i] = {objects[i].Position, objects[i].Radius, i};
+    }
+    Build(builder, 0, objects.size(), 0);
+    for (uint32_t i = 0; i < objects.size(); i++)
+    {
+        indices[i] = builder.Primitives[i].Index;
+    }
+}
+
+static float GetBoxDistance(const glm::vec3& position, const BvhNode& node)
+{
+    glm::vec3 d = glm::max(glm::max(node.Min - position, position - node.Max), glm::vec3(0.0f));
+    return glm::length(d);
+}
+
+float GetBvhDistance(std::span<const BvhNode> nodes, std::span<const Object> objects, const glm::vec3& position,
+    const std::function<bool(uint32_t)>& exclude)
+{
+    float nearest = std::numeric_limits<float>::max();
+    if (objects.empty())
+    {
+        return nearest;
+    }
+    std::vector<uint32_t> stack{0};
+    while (!stack.empty())
+    {
+        const BvhNode& node = nodes[stack.back()];
+        uint32_t index = stack.back();
+        stack.pop_back();
+        if (GetBoxDistance(position, node) >= nearest)
+        {
+            continue;
+        }
+        if (node.Count > 0)
+        {
+            for (uint32_t i = node.Offset; i < node.Offset + node.Count; i++)
+            {
+                if (!exclude(i))
+                {
+                    nearest = std::min(nearest, glm::distance(position, objects[i].Position) - objects[i].Radius);
+                }
+            }
+            continue;
+        }
+        uint32_t left = index + 1;
+        uint32_t right = node.Offset;
+        if (GetBoxDistance(position, nodes[left]) < GetBoxDistance(position, nodes[right]))
+        {
+            std::swap(left, right);
+        }
+        stack.push_back(left);
+        stack.push_back(right);
+    }
+    return nearest;
+}
+
+void RefitBvh(std::span<BvhNode> nodes, std::span<const Object> objects)
+{
+    if (objects.empty())
+    {
+        return;
+    }
+    /* NOTE: children always follow their parent so a reverse sweep visits them first */
+    for (size_t index = nodes.size(); index-- > 0;)
+    {
+        BvhNode& node = nodes[index];
+        Bounds bounds;
+        if (node.Count > 0)
+        {
+            for (uint32_t i = node.Offset; i < node.Offset + node.Count; i++)
+            {
+                bounds.Grow(GetBounds(objects[i]));
+            }
+        }
+        else
+        {
+            const BvhNode& left = nodes[index + 1];
+            const BvhNode& right = nodes[node.Offset];
+            bounds.Grow(left.Min, left.Max);
+            bounds.Grow(right.Min, right.Max);
+        }
+        node.Min = bounds.Min;
+        node.Max = bounds.Max;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "scene.hpp"
+
+/* NOTE: nodes are stored depth first so the left child of an interior node is always the next node */
+struct BvhNode
+{
+    glm::vec3 Min;
+    uint32_t Offset;
+    glm::vec3 Max;
+    uint32_t Count;
+};
+
+void BuildBvh(std::span<const Object> objects, std::vector<BvhNode>& nodes, std::vector<uint32_t>& indices);
+void RefitBvh(std::span<BvhNode> nodes, std::span<const Object> objects);
+float GetBvhDistance(std::span<const BvhNode> nodes, std::span<const Object> objects, const glm::vec3& position,
+    const std::function<bool(uint32_t)>& exclude);
@@ -0,0 +1,112 @@
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "capture.hpp"
+
+static constexpr uint32_t kHeaderSize = 14 + 40;
+
+static std::ofstream file;
+static std::string capturePath;
+static uint32_t captureWidth;
+static uint32_t captureHeight;
+static std::vector<uint8_t> row;
+
+static void Put(uint8_t*& data, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        *data++ = value >> (i * 8);
+    }
+}
+
+bool BeginCapture(const std::string_view& path, uint32_t width, uint32_t height)
+{
+    uint64_t imageSize = uint64_t(width) * height * 4;
+    if (!width || !height || kHeaderSize + imageSize > UINT32_MAX)
+    {
+        SDL_Log("Capture is too large: %ux%u", width, height);
+        return false;
+    }
+    capturePath = path;
+    file.open(capturePath, std::ios::binary | std::ios::trunc);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open capture: %s", capturePath.data());
+        return false;
+    }
+    uint8_t header[kHeaderSize];
+    uint8_t* data = header;
+    Put(data, 'B', 1);
+    Put(data, 'M', 1);
+    Put(data, kHeaderSize + imageSize, 4);
+    Put(data, 0, 4);
+    Put(data, kHeaderSize, 4);
+    Put(data, 40, 4);
+    Put(data, width, 4);
+    /* NOTE: negative height for top down rows */
+    Put(data, -int32_t(height), 4);
+    Put(data, 1, 2);
+    Put(data, 32, 2);
+    Put(data, 0, 4);
+    Put(data, imageSize, 4);
+    Put(data, 2835, 4);
+    Put(data, 2835, 4);
+    Put(data, 0, 4);
+    Put(data, 0, 4);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    /* NOTE: sized up front so tiles seek within the file instead of extending it */
+    file.seekp(kHeaderSize + imageSize - 1);
+    file.put(0);
+    captureWidth = width;
+    captureHeight = height;
+    if (file.fail())
+    {
+        SDL_Log("Failed to write capture: %s", capturePath.data());
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool WriteCapture(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* rgba, uint32_t pitch)
+{
+    width = std::min(width, captureWidth - x);
+    height = std::min(height, captureHeight - y);
+    row.resize(width * 4);
+    for (uint32_t i = 0; i < height; i++)
+    {
+        const uint8_t* source = rgba + i * pitch;
+        for (uint32_t j = 0; j < width; j++)
+        {
+            row[j * 4 + 0] = source[j * 4 + 2];
+            row[j * 4 + 1] = source[j * 4 + 1];
+            row[j * 4 + 2] = source[j * 4 + 0];
+            row[j * 4 + 3] = 255;
+        }
+        file.seekp(kHeaderSize + (uint64_t(y + i) * captureWidth + x) * 4);
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+    if (file.fail())
+    {
+        SDL_Log("Failed to write capture: %s", capturePath.data());
+        return false;
+    }
+    return true;
+}
+
+bool EndCapture()
+{
+    file.close();
+    if (file.fail())
+    {
+        SDL_Log("Failed to write capture: %s", capturePath.data());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/* NOTE: a top down 32 bit bmp sized up front and filled in a tile at a time, in any order */
+bool BeginCapture(const std::string_view& path, uint32_t width, uint32_t height);
+bool WriteCapture(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* rgba, uint32_t pitch);
+bool EndCapture();
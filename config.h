@@ -2,4 +2,33 @@
 
 #define THREADS 16
 #define WIDTH 200
-#define HEIGHT 150
\ No newline at end of file
+#define HEIGHT 150
+
+#define BVH_STACK 32
+
+#define ACCELERATION_LINEAR 0
+#define ACCELERATION_BVH 1
+#define ACCELERATION_GRID 2
+
+#define GRID_SHELLS 32
+#define GRID_THETAS 32
+#define GRID_PHIS 64
+
+#define COUNTER_STEPS 0
+#define COUNTER_TRUNCATED 1
+#define COUNTER_COUNT 2
+
+#define RESUME_NONE 0
+#define RESUME_STORE 1
+#define RESUME_CONTINUE 2
+
+#define SKY_ZS 256
+#define SKY_PHIS 512
+#define SKY_LEVELS 8
+
+#define DISK_ANGLES 1024
+#define DISK_RADII 256
+
+#define UPSCALE_NEAREST 0
+#define UPSCALE_BILINEAR 1
+#define UPSCALE_CATMULL_ROM 2
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "disk.hpp"
+#include "scene.hpp"
+#include "texture.hpp"
+
+static constexpr char kMagic[4] = {'B', 'H', 'D', 'K'};
+static constexpr uint32_t kVersion = 2;
+static constexpr int kOctaves = 6;
+static constexpr uint32_t kPeriod = 16;
+static constexpr float kRings = 6.0f;
+static constexpr float kWinding = 4.0f;
+
+struct DiskHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+/* NOTE: joins on destruction so failing before InitDisk doesn't leave the thread running */
+static std::jthread thread;
+static std::vector<uint32_t> pixels;
+static SDL_GPUTexture* texture;
+static SDL_GPUSampler* sampler;
+
+static float Lattice(int x, int y, uint32_t period, int octave)
+{
+    uint32_t h = uint32_t(x % int(period) + int(period)) % period;
+    h = h * 0x8DA6B343u ^ uint32_t(y) * 0xD8163841u ^ uint32_t(octave) * 0xCB1AB31Fu;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h / 4294967295.0f;
+}
+
+/* NOTE: value noise that wraps every period cells in x */
+static float Noise(float x, float y, uint32_t period, int octave)
+{
+    int x0 = int(std::floor(x));
+    int y0 = int(std::floor(y));
+    float fx = x - x0;
+    float fy = y - y0;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fy = fy * fy * (3.0f - 2.0f * fy);
+    float a = glm::mix(Lattice(x0, y0, period, octave), Lattice(x0 + 1, y0, period, octave), fx);
+    float b = glm::mix(Lattice(x0, y0 + 1, period, octave), Lattice(x0 + 1, y0 + 1, period, octave), fx);
+    return glm::mix(a, b, fy);
+}
+
+static uint32_t Shade(float u, float v)
+{
+    /* NOTE: thin disk temperature profile peaking near the inner edge */
+    float r = glm::mix(kDiskR1, kDiskR2, v) / kDiskR1;
+    float temperature = std::pow(r, -0.75f) * std::pow(std::max(0.0f, 1.0f - std::sqrt(1.0f / r)), 0.25f) / 0.488f;
+    /* NOTE: the disk only spans a factor of ~2.4 in radius so the profile is steepened to show a gradient */
+    temperature = std::pow(glm::clamp(temperature, 0.0f, 1.0f), 4.0f);
+    /* NOTE: turbulence sheared into trailing spirals, faster inside like the orbits */
+    float x = u * kPeriod + kWinding * std::log(r) * kPeriod;
+    float y = v * kRings;
+    float noise = 0.0f;
+    float amplitude = 0.5f;
+    for (int octave = 0; octave < kOctaves; octave++)
+    {
+        float scale = float(1 << octave);
+        noise += amplitude * Noise(x * scale, y * scale * 4.0f, kPeriod << octave, octave);
+        amplitude *= 0.5f;
+    }
+    /* NOTE: opaque out to the edges since the shader ends the ray on the disk, the radii are the hard cutoff */
+    float brightness = (0.2f + 0.8f * glm::smoothstep(0.3f, 0.75f, noise)) * (0.4f + 0.6f * temperature);
+    glm::vec3 cool(1.0f, 0.3f, 0.08f);
+    glm::vec3 warm(1.0f, 0.8f, 0.45f);
+    glm::vec3 hot(0.85f, 0.9f, 1.0f);
+    glm::vec3 color = temperature < 0.6f ? glm::mix(cool, warm, temperature / 0.6f) : glm::mix(warm, hot, (temperature - 0.6f) / 0.4f);
+    color *= brightness;
+    uint32_t red = uint32_t(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint32_t green = uint32_t(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+    uint32_t blue = uint32_t(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return red | (green << 8) | (blue << 16) | (255u << 24);
+}
+
+void BakeDisk(std::vector<uint32_t>& pixels)
+{
+    pixels.resize(DISK_ANGLES * DISK_RADII);
+    for (uint32_t y = 0; y < DISK_RADII; y++)
+    {
+        for (uint32_t x = 0; x < DISK_ANGLES; x++)
+        {
+            pixels[y * DISK_ANGLES + x] = Shade((x + 0.5f) / DISK_ANGLES, (y + 0.5f) / DISK_RADII);
+        }
+    }
+}
+
+static bool Load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (file.fail())
+    {
+        return false;
+    }
+    DiskHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (file.fail() || std::memcmp(header.Magic, kMagic, sizeof(kMagic)) || header.Version != kVersion ||
+        header.Width != DISK_ANGLES || header.Height != DISK_RADII)
+    {
+        SDL_Log("Ignoring stale disk cache: %s", path.data());
+        return false;
+    }
+    pixels.resize(DISK_ANGLES * DISK_RADII);
+    file.read(reinterpret_cast<char*>(pixels.data()), pixels.size() * sizeof(uint32_t));
+    return !file.fail();
+}
+
+static void Save(const std::string& path)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    DiskHeader header{};
+    std::memcpy(header.Magic, kMagic, sizeof(kMagic));
+    header.Version = kVersion;
+    header.Width = DISK_ANGLES;
+    header.Height = DISK_RADII;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size() * sizeof(uint32_t));
+    if (file.fail())
+    {
+        SDL_Log("Failed to write disk cache: %s", path.data());
+    }
+}
+
+static void Generate(const std::string& cachePath)
+{
+    uint64_t start = SDL_GetTicksNS();
+    if (!cachePath.empty() && Load(cachePath))
+    {
+        SDL_Log("Loaded disk texture in %.2fms", (SDL_GetTicksNS() - start) / 1.0e6);
+        return;
+    }
+    BakeDisk(pixels);
+    SDL_Log("Generated disk texture in %.2fms", (SDL_GetTicksNS() - start) / 1.0e6);
+    if (!cachePath.empty())
+    {
+        Save(cachePath);
+    }
+}
+
+void BeginDisk(const char* cachePath)
+{
+    thread = std::jthread(Generate, std::string(cachePath ? cachePath : ""));
+}
+
+bool InitDisk(SDL_GPUDevice* device)
+{
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+    if (pixels.size() != DISK_ANGLES * DISK_RADII)
+    {
+        SDL_Log("Failed to generate disk texture");
+        return false;
+    }
+    {
+        SDL_GPUTextureCreateInfo info{};
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.width = DISK_ANGLES;
+        info.height = DISK_RADII;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        texture = SDL_CreateGPUTexture(device, &info);
+        if (!texture)
+        {
+            SDL_Log("Failed to create texture: %s", SDL_GetError());
+            return false;
+        }
+    }
+    {
+        SDL_GPUSamplerCreateInfo info{};
+        info.min_filter = SDL_GPU_FILTER_LINEAR;
+        info.mag_filter = SDL_GPU_FILTER_LINEAR;
+        info.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
+        info.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+        info.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+        info.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+        sampler = SDL_CreateGPUSampler(device, &info);
+        if (!sampler)
+        {
+            SDL_Log("Failed to create sampler: %s", SDL_GetError());
+            return false;
+        }
+    }
+    bool uploaded = UploadTexture(device, texture, pixels.data(), DISK_ANGLES, DISK_RADII, DISK_ANGLES * sizeof(uint32_t), false);
+    pixels = {};
+    return uploaded;
+}
+
+void QuitDisk(SDL_GPUDevice* device)
+{
+    SDL_ReleaseGPUSampler(device, sampler);
+    SDL_ReleaseGPUTexture(device, texture);
+}
+
+SDL_GPUTextureSamplerBinding GetDisk()
+{
+    SDL_GPUTextureSamplerBinding binding{};
+    binding.texture = texture;
+    binding.sampler = sampler;
+    return binding;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+#include <vector>
+
+/* NOTE: rgba8 texture over (angle, radius) between the disk radii, tileable in angle */
+void BeginDisk(const char* cachePath);
+void BakeDisk(std::vector<uint32_t>& pixels);
+bool InitDisk(SDL_GPUDevice* device);
+void QuitDisk(SDL_GPUDevice* device);
+SDL_GPUTextureSamplerBinding GetDisk();
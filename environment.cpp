@@ -0,0 +1,88 @@
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "environment.hpp"
+#include "texture.hpp"
+
+static SDL_GPUTexture* texture;
+static SDL_GPUSampler* sampler;
+
+bool InitEnvironment(SDL_GPUDevice* device, const char* path)
+{
+    SDL_Surface* surface = nullptr;
+    if (path)
+    {
+        SDL_Surface* image = SDL_LoadBMP(path);
+        if (!image)
+        {
+            SDL_Log("Failed to load environment: %s", SDL_GetError());
+            return false;
+        }
+        surface = SDL_ConvertSurface(image, SDL_PIXELFORMAT_RGBA32);
+        SDL_DestroySurface(image);
+        if (!surface)
+        {
+            SDL_Log("Failed to convert environment: %s", SDL_GetError());
+            return false;
+        }
+    }
+    uint32_t width = surface ? surface->w : 1;
+    uint32_t height = surface ? surface->h : 1;
+    {
+        SDL_GPUTextureCreateInfo info{};
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.width = width;
+        info.height = height;
+        info.layer_count_or_depth = 1;
+        info.num_levels = std::bit_width(std::max(width, height));
+        texture = SDL_CreateGPUTexture(device, &info);
+        if (!texture)
+        {
+            SDL_Log("Failed to create texture: %s", SDL_GetError());
+            SDL_DestroySurface(surface);
+            return false;
+        }
+    }
+    {
+        SDL_GPUSamplerCreateInfo info{};
+        info.min_filter = SDL_GPU_FILTER_LINEAR;
+        info.mag_filter = SDL_GPU_FILTER_LINEAR;
+        info.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
+        info.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+        info.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+        info.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+        info.max_lod = 1000.0f;
+        sampler = SDL_CreateGPUSampler(device, &info);
+        if (!sampler)
+        {
+            SDL_Log("Failed to create sampler: %s", SDL_GetError());
+            SDL_DestroySurface(surface);
+            return false;
+        }
+    }
+    uint32_t black = 0xFF000000;
+    bool uploaded = surface
+        ? UploadTexture(device, texture, surface->pixels, width, height, surface->pitch, true)
+        : UploadTexture(device, texture, &black, 1, 1, sizeof(black), false);
+    SDL_DestroySurface(surface);
+    return uploaded;
+}
+
+void QuitEnvironment(SDL_GPUDevice* device)
+{
+    SDL_ReleaseGPUSampler(device, sampler);
+    SDL_ReleaseGPUTexture(device, texture);
+}
+
+SDL_GPUTextureSamplerBinding GetEnvironment()
+{
+    SDL_GPUTextureSamplerBinding binding{};
+    binding.texture = texture;
+    binding.sampler = sampler;
+    return binding;
+}
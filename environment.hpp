@@ -0,0 +1,8 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+/* NOTE: equirectangular background with a full mip chain, a black texel when no path is given */
+bool InitEnvironment(SDL_GPUDevice* device, const char* path);
+void QuitEnvironment(SDL_GPUDevice* device);
+SDL_GPUTextureSamplerBinding GetEnvironment();
@@ -0,0 +1,165 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "bvh.hpp"
+#include "config.h"
+#include "grid.hpp"
+#include "scene.hpp"
+
+struct CellBounds
+{
+    glm::vec3 Center;
+    float Radius;
+};
+
+static float GetShellRadius(const Grid& grid, int shell)
+{
+    return grid.Inner * std::pow(grid.Outer / grid.Inner, float(shell) / GRID_SHELLS);
+}
+
+static int GetCell(int shell, int theta, int phi)
+{
+    return (shell * GRID_THETAS + theta) * GRID_PHIS + phi;
+}
+
+static CellBounds GetCellBounds(const Grid& grid, int shell, int theta, int phi)
+{
+    float r0 = GetShellRadius(grid, shell);
+    float r1 = GetShellRadius(grid, shell + 1);
+    float dtheta = glm::pi<float>() / GRID_THETAS;
+    float dphi = glm::two_pi<float>() / GRID_PHIS;
+    float theta0 = theta * dtheta;
+    float theta1 = theta0 + dtheta;
+    float thetaM = theta0 + dtheta * 0.5f;
+    float phiM = -glm::pi<float>() + (phi + 0.5f) * dphi;
+    float rM = (r0 + r1) * 0.5f;
+    float maxSin = (theta0 <= glm::half_pi<float>() && theta1 >= glm::half_pi<float>())
+        ? 1.0f : std::max(std::sin(theta0), std::sin(theta1));
+    /* NOTE: radial half extent plus an upper bound on the arc from the center direction */
+    CellBounds bounds;
+    bounds.Center = rM * glm::vec3(
+        std::sin(thetaM) * std::cos(phiM),
+        std::sin(thetaM) * std::sin(phiM),
+        std::cos(thetaM));
+    bounds.Radius = (r1 - r0) * 0.5f + r1 * (dtheta * 0.5f + maxSin * dphi * 0.5f);
+    return bounds;
+}
+
+bool BuildGrid(std::span<const Object> objects, std::span<const BvhNode> nodes, Grid& grid)
+{
+    grid.Inner = kBlackHoleRadius * 3.0f;
+    grid.Outer = 0.0f;
+    for (const Object& object : objects)
+    {
+        grid.Outer = std::max(grid.Outer, glm::length(object.Position) + object.Radius);
+    }
+    if (grid.Outer <= grid.Inner * 1.01f)
+    {
+        return false;
+    }
+    grid.Outer *= 1.01f;
+    static constexpr int kCells = GRID_SHELLS * GRID_THETAS * GRID_PHIS;
+    std::vector<std::vector<uint32_t>> lists(kCells);
+    float logScale = GRID_SHELLS / std::log(grid.Outer / grid.Inner);
+    auto getShell = [&](float r)
+    {
+        return std::clamp(int(std::floor(std::log(std::max(r, grid.Inner) / grid.Inner) * logScale)), 0, GRID_SHELLS - 1);
+    };
+    for (uint32_t i = 0; i < objects.size(); i++)
+    {
+        const Object& object = objects[i];
+        float d = glm::length(object.Position);
+        if (d - object.Radius >= grid.Outer || d + object.Radius < grid.Inner)
+        {
+            continue;
+        }
+        int shell0 = getShell(d - object.Radius);
+        int shell1 = getShell(d + object.Radius);
+        int theta0 = 0;
+        int theta1 = GRID_THETAS - 1;
+        int phi0 = 0;
+        int phi1 = GRID_PHIS - 1;
+        if (d > object.Radius)
+        {
+            /* NOTE: angular extent of the object as seen from the hole */
+            float alpha = std::asin(object.Radius / d);
+            float theta = std::acos(std::clamp(object.Position.z / d, -1.0f, 1.0f));
+            float phi = std::atan2(object.Position.y, object.Position.x);
+            float lo = theta - alpha;
+            float hi = theta + alpha;
+            theta0 = std::clamp(int(lo / glm::pi<float>() * GRID_THETAS), 0, GRID_THETAS - 1);
+            theta1 = std::clamp(int(hi / glm::pi<float>() * GRID_THETAS), 0, GRID_THETAS - 1);
+            float minSin = std::min(std::sin(std::max(lo, 0.0f)), std::sin(std::min(hi, glm::pi<float>())));
+            if (lo > 0.0f && hi < glm::pi<float>() && std::sin(alpha) < minSin)
+            {
+                float width = std::asin(std::sin(alpha) / minSin);
+                phi0 = int(std::floor((phi - width + glm::pi<float>()) / glm::two_pi<float>() * GRID_PHIS));
+                phi1 = int(std::floor((phi + width + glm::pi<float>()) / glm::two_pi<float>() * GRID_PHIS));
+            }
+        }
+        for (int shell = shell0; shell <= shell1; shell++)
+        {
+            for (int theta = theta0; theta <= theta1; theta++)
+            {
+                for (int p = phi0; p <= phi1; p++)
+                {
+                    int phi = (p % GRID_PHIS + GRID_PHIS) % GRID_PHIS;
+                    CellBounds bounds = GetCellBounds(grid, shell, theta, phi);
+                    if (glm::distance(bounds.Center, object.Position) - object.Radius < bounds.Radius)
+                    {
+                        std::vector<uint32_t>& list = lists[GetCell(shell, theta, phi)];
+                        if (list.empty() || list.back() != i)
+                        {
+                            list.push_back(i);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    grid.Cells.assign(kCells, GridCell{});
+    grid.Indices.clear();
+    for (int i = 0; i < kCells; i++)
+    {
+        grid.Cells[i].Offset = grid.Indices.size();
+        grid.Cells[i].Count = lists[i].size();
+        grid.Indices.insert(grid.Indices.end(), lists[i].begin(), lists[i].end());
+    }
+    std::atomic<int> next = 0;
+    auto worker = [&]()
+    {
+        for (int i = next++; i < kCells; i = next++)
+        {
+            int shell = i / (GRID_THETAS * GRID_PHIS);
+            int theta = i / GRID_PHIS % GRID_THETAS;
+            int phi = i % GRID_PHIS;
+            CellBounds bounds = GetCellBounds(grid, shell, theta, phi);
+            const std::vector<uint32_t>& list = lists[i];
+            float distance = GetBvhDistance(nodes, objects, bounds.Center, [&](uint32_t index)
+            {
+                return std::find(list.begin(), list.end(), index) != list.end();
+            });
+            grid.Cells[i].Center = bounds.Center;
+            grid.Cells[i].Distance = distance;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < std::max(1u, std::thread::hardware_concurrency()); i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    return true;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bvh.hpp"
+#include "scene.hpp"
+
+/* NOTE: distance from the cell center to the closest object not in the cell's list, so that
+ * distance - length(position - center) bounds every unlisted object from any point in the cell */
+struct GridCell
+{
+    glm::vec3 Center;
+    float Distance;
+    uint32_t Offset;
+    uint32_t Count;
+    uint32_t Padding[2];
+};
+
+struct Grid
+{
+    float Inner;
+    float Outer;
+    std::vector<GridCell> Cells;
+    std::vector<uint32_t> Indices;
+};
+
+bool BuildGrid(std::span<const Object> objects, std::span<const BvhNode> nodes, Grid& grid);
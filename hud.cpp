@@ -0,0 +1,159 @@
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hud.hpp"
+
+static constexpr int kGlyphWidth = 3;
+static constexpr int kGlyphHeight = 5;
+static constexpr int kCellWidth = kGlyphWidth + 1;
+static constexpr int kCellHeight = kGlyphHeight + 2;
+static constexpr int kMargin = 2;
+static constexpr int kColumns = 48;
+/* NOTE: enough for every line main can push at once */
+static constexpr int kRows = 12;
+static constexpr int kWidth = kColumns * kCellWidth + kMargin * 2;
+static constexpr int kHeight = kRows * kCellHeight + kMargin * 2;
+static constexpr int kScale = 2;
+static constexpr int kOffset = 8;
+static constexpr uint32_t kBackground = 0xFF101010;
+static constexpr uint32_t kForeground = 0xFFFFFFFF;
+
+/* NOTE: 3x5 glyphs for ' ' to '_', 5 rows of 3 bits with the top left pixel in the highest bit */
+static constexpr uint16_t kFont[64] =
+{
+    0x0000, 0x2482, 0x5a00, 0x5f7d, 0x3c9e, 0x52a5, 0x2aab, 0x2400,
+    0x2922, 0x224a, 0x0aa8, 0x05d0, 0x0014, 0x01c0, 0x0002, 0x12a4,
+    0x7b6f, 0x2c97, 0x73e7, 0x72cf, 0x5bc9, 0x79cf, 0x79ef, 0x7252,
+    0x7bef, 0x7bcf, 0x0410, 0x0414, 0x1511, 0x0e38, 0x4454, 0x6282,
+    0x7be7, 0x2bed, 0x6bae, 0x3923, 0x6b6e, 0x79a7, 0x79a4, 0x396b,
+    0x5bed, 0x7497, 0x126a, 0x5bad, 0x4927, 0x5fed, 0x6b6d, 0x2b6a,
+    0x6ba4, 0x2b73, 0x6bad, 0x388e, 0x7492, 0x5b6f, 0x5b6a, 0x5bfd,
+    0x5aad, 0x5a92, 0x72a7, 0x6926, 0x4889, 0x324b, 0x2a00, 0x0007,
+};
+
+static SDL_GPUTexture* texture;
+static SDL_GPUTransferBuffer* transferBuffer;
+static std::vector<std::string> text;
+
+bool InitHud(SDL_GPUDevice* device)
+{
+    {
+        SDL_GPUTextureCreateInfo info{};
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.width = kWidth;
+        info.height = kHeight;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        texture = SDL_CreateGPUTexture(device, &info);
+        if (!texture)
+        {
+            SDL_Log("Failed to create texture: %s", SDL_GetError());
+            return false;
+        }
+    }
+    {
+        SDL_GPUTransferBufferCreateInfo info{};
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        info.size = kWidth * kHeight * sizeof(uint32_t);
+        transferBuffer = SDL_CreateGPUTransferBuffer(device, &info);
+        if (!transferBuffer)
+        {
+            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+            return false;
+        }
+    }
+    return true;
+}
+
+void QuitHud(SDL_GPUDevice* device)
+{
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    SDL_ReleaseGPUTexture(device, texture);
+}
+
+void UpdateHud(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer, const std::vector<std::string>& lines)
+{
+    /* NOTE: only rasterize and upload when the text changes */
+    if (lines == text)
+    {
+        return;
+    }
+    text = lines;
+    uint32_t* pixels = static_cast<uint32_t*>(SDL_MapGPUTransferBuffer(device, transferBuffer, true));
+    if (!pixels)
+    {
+        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+        return;
+    }
+    std::fill(pixels, pixels + kWidth * kHeight, kBackground);
+    for (int row = 0; row < std::min(int(text.size()), kRows); row++)
+    {
+        const std::string& line = text[row];
+        for (int column = 0; column < std::min(int(line.size()), kColumns); column++)
+        {
+            int character = std::toupper(static_cast<unsigned char>(line[column]));
+            if (character < ' ' || character > '_')
+            {
+                continue;
+            }
+            uint16_t glyph = kFont[character - ' '];
+            for (int y = 0; y < kGlyphHeight; y++)
+            {
+                for (int x = 0; x < kGlyphWidth; x++)
+                {
+                    int bit = (kGlyphHeight - y) * kGlyphWidth - x - 1;
+                    if (!(glyph & (1 << bit)))
+                    {
+                        continue;
+                    }
+                    int pixelX = kMargin + column * kCellWidth + x;
+                    int pixelY = kMargin + row * kCellHeight + y + 1;
+                    pixels[pixelY * kWidth + pixelX] = kForeground;
+                }
+            }
+        }
+    }
+    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    if (!copyPass)
+    {
+        SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+        return;
+    }
+    SDL_GPUTextureTransferInfo info{};
+    SDL_GPUTextureRegion region{};
+    info.transfer_buffer = transferBuffer;
+    region.texture = texture;
+    region.w = kWidth;
+    region.h = kHeight;
+    region.d = 1;
+    SDL_UploadToGPUTexture(copyPass, &info, &region, true);
+    SDL_EndGPUCopyPass(copyPass);
+}
+
+void DrawHud(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTexture* swapchainTexture, uint32_t width, uint32_t height)
+{
+    if (text.empty() || width < kWidth * kScale + kOffset || height < kHeight * kScale + kOffset)
+    {
+        return;
+    }
+    SDL_GPUBlitInfo info{};
+    info.load_op = SDL_GPU_LOADOP_LOAD;
+    info.source.texture = texture;
+    info.source.w = kWidth;
+    info.source.h = kHeight;
+    info.destination.texture = swapchainTexture;
+    info.destination.x = kOffset;
+    info.destination.y = kOffset;
+    info.destination.w = kWidth * kScale;
+    info.destination.h = kHeight * kScale;
+    info.filter = SDL_GPU_FILTER_NEAREST;
+    SDL_BlitGPUTexture(commandBuffer, &info);
+}
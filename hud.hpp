@@ -0,0 +1,11 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <string>
+#include <vector>
+
+bool InitHud(SDL_GPUDevice* device);
+void QuitHud(SDL_GPUDevice* device);
+void UpdateHud(SDL_GPUDevice* device, SDL_GPUCommandBuffer* commandBuffer, const std::vector<std::string>& lines);
+void DrawHud(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTexture* swapchainTexture, uint32_t width, uint32_t height);
@@ -0,0 +1,124 @@
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "instance.hpp"
+#include "scene.hpp"
+
+static constexpr glm::uvec3 kMax{(1u << 21) - 1, (1u << 21) - 1, (1u << 22) - 1};
+
+static glm::uvec3 Quantize(const glm::vec3& position, const InstanceSet& set)
+{
+    glm::uvec3 q;
+    for (int i = 0; i < 3; i++)
+    {
+        float value = set.Scale[i] > 0.0f ? std::round((position[i] - set.Min[i]) / set.Scale[i]) : 0.0f;
+        q[i] = uint32_t(std::clamp(value, 0.0f, float(kMax[i])));
+    }
+    return q;
+}
+
+static glm::vec3 Dequantize(const glm::uvec3& q, const InstanceSet& set)
+{
+    return set.Min + glm::vec3(q) * set.Scale;
+}
+
+void GetInstanceBounds(std::span<const Object> objects, InstanceSet& set, float padding)
+{
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{-std::numeric_limits<float>::max()};
+    for (const Object& object : objects)
+    {
+        min = glm::min(min, object.Position);
+        max = glm::max(max, object.Position);
+    }
+    if (objects.empty())
+    {
+        min = glm::vec3(0.0f);
+        max = glm::vec3(0.0f);
+    }
+    glm::vec3 pad = (max - min) * padding;
+    set.Min = min - pad;
+    set.Scale = (max - min + pad * 2.0f) / glm::vec3(kMax);
+}
+
+bool ContainsInstances(std::span<const Object> objects, const InstanceSet& set)
+{
+    glm::vec3 max = set.Min + glm::vec3(kMax) * set.Scale;
+    for (const Object& object : objects)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            if (object.Position[i] < set.Min[i] || object.Position[i] > max[i])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+glm::vec3 SnapPosition(const glm::vec3& position, const InstanceSet& set)
+{
+    return Dequantize(Quantize(position, set), set);
+}
+
+void BuildInstances(std::span<const Object> objects, InstanceSet& set)
+{
+    struct Hash
+    {
+        size_t operator()(const Prototype& prototype) const
+        {
+            uint32_t words[4];
+            std::memcpy(words, &prototype, sizeof(words));
+            return ((size_t(words[0]) * 31 + words[1]) * 31 + words[2]) * 31 + words[3];
+        }
+    };
+    struct Equal
+    {
+        bool operator()(const Prototype& a, const Prototype& b) const
+        {
+            return !std::memcmp(&a, &b, sizeof(Prototype));
+        }
+    };
+    std::unordered_map<Prototype, uint32_t, Hash, Equal> ids;
+    for (uint32_t i = 0; i < set.Prototypes.size(); i++)
+    {
+        ids.try_emplace(set.Prototypes[i], i);
+    }
+    set.Instances.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        Prototype prototype{objects[i].Color, objects[i].Radius};
+        auto [it, inserted] = ids.try_emplace(prototype, uint32_t(set.Prototypes.size()));
+        if (inserted)
+        {
+            set.Prototypes.push_back(prototype);
+        }
+        glm::uvec3 q = Quantize(objects[i].Position, set);
+        Instance& instance = set.Instances[i];
+        instance.Position[0] = q.x | (q.y << 21);
+        instance.Position[1] = (q.y >> 11) | (q.z << 10);
+        instance.Prototype = it->second;
+    }
+}
+
+float GetInstanceRadius(const InstanceSet& set)
+{
+    /* NOTE: farthest corner of the quantized bounds plus the largest radius, so every instance is inside */
+    glm::vec3 min = set.Min;
+    glm::vec3 max = set.Min + glm::vec3(kMax) * set.Scale;
+    float radius = 0.0f;
+    for (const Prototype& prototype : set.Prototypes)
+    {
+        radius = std::max(radius, prototype.Radius);
+    }
+    return glm::length(glm::max(glm::abs(min), glm::abs(max))) + radius;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "scene.hpp"
+
+/* NOTE: what objects of one kind share, mass stays on the cpu with the scene */
+struct Prototype
+{
+    glm::vec3 Color;
+    float Radius;
+};
+
+/* NOTE: position quantized to 21, 21 and 22 bits over the scene bounds, packed into two words */
+struct Instance
+{
+    uint32_t Position[2];
+    uint32_t Prototype;
+};
+
+struct InstanceSet
+{
+    glm::vec3 Min;
+    glm::vec3 Scale;
+    std::vector<Prototype> Prototypes;
+    std::vector<Instance> Instances;
+};
+
+/* NOTE: padding widens each side by that fraction of the extent so moving objects can stay inside */
+void GetInstanceBounds(std::span<const Object> objects, InstanceSet& set, float padding = 0.0f);
+bool ContainsInstances(std::span<const Object> objects, const InstanceSet& set);
+glm::vec3 SnapPosition(const glm::vec3& position, const InstanceSet& set);
+/* NOTE: prototypes already in the set keep their ids, new ones are appended */
+void BuildInstances(std::span<const Object> objects, InstanceSet& set);
+float GetInstanceRadius(const InstanceSet& set);
@@ -0,0 +1,55 @@
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bvh.hpp"
+#include "lens.hpp"
+#include "scene.hpp"
+
+static float GetSchwarzschildRadius(float mass)
+{
+    return 2.0f * kG * mass / (kC * kC);
+}
+
+float GetLensInfluence(float mass, float tolerance)
+{
+    /* NOTE: a ray passing at b is deflected by 2 rs / b */
+    return 2.0f * GetSchwarzschildRadius(mass) / tolerance;
+}
+
+void BuildLenses(std::span<const Object> objects, float tolerance, LensSet& set)
+{
+    set.Lenses.clear();
+    set.Nodes.clear();
+    std::vector<Object> spheres;
+    std::vector<Lens> lenses;
+    for (const Object& object : objects)
+    {
+        if (object.Mass <= 0.0f || glm::length(object.Position) <= kBlackHoleRadius)
+        {
+            continue;
+        }
+        float influence = GetLensInfluence(object.Mass, tolerance);
+        if (influence <= object.Radius)
+        {
+            continue;
+        }
+        Object sphere = object;
+        sphere.Radius = influence;
+        spheres.push_back(sphere);
+        lenses.push_back({object.Position, GetSchwarzschildRadius(object.Mass)});
+    }
+    if (spheres.empty())
+    {
+        return;
+    }
+    std::vector<uint32_t> indices;
+    BuildBvh(spheres, set.Nodes, indices);
+    set.Lenses.reserve(indices.size());
+    for (uint32_t index : indices)
+    {
+        set.Lenses.push_back(lenses[index]);
+    }
+}
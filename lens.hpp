@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <vector>
+
+#include "bvh.hpp"
+#include "scene.hpp"
+
+/* NOTE: a mass that deflects passing rays, radius is its schwarzschild radius */
+struct Lens
+{
+    glm::vec3 Position;
+    float Radius;
+};
+
+struct LensSet
+{
+    std::vector<Lens> Lenses;
+    std::vector<BvhNode> Nodes;
+};
+
+/* NOTE: beyond this distance a lens deflects a ray by less than tolerance radians in total */
+float GetLensInfluence(float mass, float tolerance);
+
+/* NOTE: the central hole is already the metric, objects whose influence doesn't reach past their
+ * own surface are dropped and the nodes bound influence spheres in lens order */
+void BuildLenses(std::span<const Object> objects, float tolerance, LensSet& set);
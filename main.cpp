@@ -5,19 +5,60 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
+#include "benchmark.hpp"
+#include "bvh.hpp"
+#include "capture.hpp"
 #include "config.h"
+#include "disk.hpp"
+#include "environment.hpp"
+#include "grid.hpp"
+#include "hud.hpp"
+#include "instance.hpp"
+#include "lens.hpp"
+#include "nbody.hpp"
+#include "prefetch.hpp"
+#include "replay.hpp"
+#include "scene.hpp"
 #include "shader.hpp"
+#include "sky.hpp"
+#include "snapshot.hpp"
+#include "stats.hpp"
+#include "stream.hpp"
+#include "telemetry.hpp"
+#include "upscale.hpp"
 
 static constexpr float kPan = 0.002f;
 static constexpr float kZoom = 25.0e9f;
 static constexpr float kFov = glm::radians<float>(60.0f);
-static constexpr float kC = 299792458.0f;
-static constexpr float kG = 6.67430e-11f;
-static constexpr float kBlackHoleMass = 8.54e36f;
-static constexpr float kBlackHoleRadius = 2.0f * kG * kBlackHoleMass / (kC * kC);
+static constexpr float kClamp = glm::pi<float>() / 2.0f - 0.01f;
+static constexpr int kFrames = 3;
+static constexpr int kHudFrames = 120;
+static constexpr uint64_t kHudInterval = SDL_MS_TO_NS(250);
+static constexpr uint32_t kSyntheticInterval = 100;
+static constexpr int kThroughputWarmup = 20;
+static constexpr float kSyntheticStep = 8.0f;
+static constexpr uint32_t kUploadChunk = 4 * 1024 * 1024;
+static constexpr uint32_t kBvhThreshold = 16;
+static constexpr uint32_t kInsetScale = 2;
+static constexpr uint32_t kInsetSlots = 4;
+static constexpr uint32_t kCaptureTile = 128;
+static constexpr uint32_t kMinSteps = 64;
+static constexpr uint32_t kMaxSteps = 60000;
+/* NOTE: the shader's ray state is 64 bytes packed, this also fits the 16 byte aligned layout */
+static constexpr uint32_t kRayStateSize = 80;
 
 struct UniformBuffer
 {
@@ -28,16 +69,53 @@ struct UniformBuffer
     glm::vec3 CameraUp;
     uint32_t ObjectCount;
     glm::vec3 CameraForward;
-    float DiskR1 = kBlackHoleRadius * 2.2f;
-    float DiskR2 = kBlackHoleRadius * 5.2f;
+    float DiskR1 = kDiskR1;
+    glm::vec3 InstanceMin;
+    float DiskR2 = kDiskR2;
+    glm::vec3 InstanceScale;
+    uint32_t Counters;
+    uint32_t Acceleration;
+    float GridInner;
+    float GridOuter;
+    float GridScale;
+    uint32_t StarCount;
+    uint32_t LensCount;
+    float LensTolerance;
+    uint32_t MaxSteps = kMaxSteps;
+    uint32_t Resume;
+    uint32_t CountTruncated;
+    float SceneRadius;
 };
 
-struct Object
+struct CameraState
 {
-    glm::vec3 Position;
-    float Radius;
-    glm::vec3 Color;
-    float Mass;
+    float Pitch;
+    float Yaw;
+    float Distance{1.0e11f};
+};
+
+/* NOTE: an inset following the main camera, orbited by yaw and pitch in degrees and zoomed by narrowing the fov */
+struct Viewport
+{
+    float Yaw;
+    float Pitch;
+    float Zoom;
+    CameraState Camera;
+    SDL_GPUTexture* Texture;
+};
+
+/* NOTE: published by the event thread and taken by the render thread at the start of each frame */
+struct InputState
+{
+    CameraState Camera;
+    /* NOTE: yaw and pitch change of the last drag event, independent of how often frames read it */
+    glm::vec2 Drag;
+    bool Hud;
+    bool Counters;
+    float RefreshRate;
+    uint32_t Captures;
+    /* NOTE: stamp of the oldest camera input not yet shown, every snapshot carrying it includes that input */
+    uint64_t InputTime;
 };
 
 static SDL_Window* window;
@@ -45,255 +123,2094 @@ static SDL_GPUDevice* device;
 static SDL_GPUComputePipeline* geodesicPipeline;
 static SDL_GPUTexture* colorTexture;
 static SDL_GPUBuffer* objectBuffer;
-static float pitch;
-static float yaw;
-static float distance{1.0e11f};
+static SDL_GPUBuffer* prototypeBuffer;
+static SDL_GPUBuffer* nodeBuffer;
+static SDL_GPUBuffer* cellBuffer;
+static SDL_GPUBuffer* cellObjectBuffer;
+static SDL_GPUBuffer* skyBuffer;
+static SDL_GPUBuffer* lensBuffer;
+static SDL_GPUBuffer* lensNodeBuffer;
+static StreamBuffer objectStream;
+static StreamBuffer prototypeStream;
+static StreamBuffer nodeStream;
+static SDL_GPUBuffer* counterBuffer;
+static SDL_GPUBuffer* rayStateBuffer;
+static SDL_GPUTransferBuffer* counterUploadBuffer;
+static SDL_GPUTransferBuffer* counterDownloadBuffers[kFrames];
+static SDL_GPUFence* fences[kFrames];
+static uint64_t submitTimes[kFrames];
+static bool countersPending[kFrames];
+static uint64_t inputTimes[kFrames];
+static int frameIndex;
+static Scene scene;
+static CameraState camera;
+static glm::vec2 drag;
 static UniformBuffer uniformBuffer;
+static std::atomic<uint64_t> frame;
+static FrameStats frameStats;
+static const char* recordPath;
+static const char* replayPath;
+static const char* statsPath;
+static ReplayTiming replayTiming = ReplayTiming::Fixed;
+static const char* benchmarkPath;
+static const char* baselinePath;
+static double benchmarkThreshold = 5.0;
+static int benchmarkRepetitions = 10;
+static int benchmarkFrames = 20;
+static bool hudEnabled;
+static FrameStats hudStats;
+static std::vector<std::string> hudLines;
+static uint64_t hudTime;
+static double gpuTime;
+static double stepsPerPixel;
+static uint32_t windowWidth;
+static uint32_t windowHeight;
+static const char* telemetryPath;
+static TelemetryFormat telemetryFormat = TelemetryFormat::Jsonl;
+static uint64_t telemetryBytes = 64 * 1024 * 1024;
+static int telemetryFiles = 4;
+static const char* scenePath;
+static const char* exportScenePath;
+static uint32_t randomSceneCount;
+static const char* accelerationName;
+static const char* catalogPath;
+static const char* environmentPath;
+static const char* diskCachePath;
+static uint32_t randomStarCount;
+static float lensTolerance;
+static bool simulate;
+static NBodySettings simulationSettings;
+static int simulationBenchmarkSteps;
+static InstanceSet simulationInstances;
+static std::vector<BvhNode> simulationNodes;
+static FrameStats uploadStats;
+static uint64_t uploadBytes;
+static double uploadTime;
+static uint32_t uploadFrameBytes;
+static SDL_GPUPresentMode presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+static bool latencyFirst;
+static int framesInFlight;
+static uint64_t inputTime;
+static FrameStats completeLatencyStats;
+static FrameStats presentLatencyStats;
+static uint64_t presentInputTime;
+static uint32_t syntheticInputCount;
+static std::atomic<uint32_t> syntheticInputs;
+static double throughputSeconds;
+static bool headless;
+static uint32_t upscaleFilter = UPSCALE_CATMULL_ROM;
+static bool upscaleBlit;
+static std::vector<Viewport> viewports;
+static const char* capturePath = "capture.bmp";
+static uint32_t captureWidth = 7680;
+static uint32_t captureHeight = 4320;
+static double captureBudget;
+static uint32_t captureRequests;
+static bool capturing;
+static CameraState captureCamera;
+static uint32_t captureTile;
+static double captureTileTime;
+static uint64_t captureStart;
+static SDL_GPUTexture* captureTexture;
+static SDL_GPUTransferBuffer* captureDownloadBuffer;
+static double frameTarget;
+static uint32_t maxSteps = kMaxSteps;
+static uint32_t truncatedRays;
+static uint64_t completeTime;
+static bool resumable;
+static bool resuming;
+static bool prefetchEnabled;
+static bool refining;
+static uint64_t prefetchFrames;
+static uint64_t prefetchHits;
+static uint64_t prefetchExactHits;
+static bool dirty = true;
+static float refreshRate;
+static InputState input;
+static Snapshot<InputState> inputSnapshot;
+static std::atomic<uint64_t> pendingInputTime;
+static std::atomic<bool> running;
 
-static bool Init()
+static bool ParseArgs(int argc, char** argv)
 {
-    SDL_SetAppMetadata("Black Hole Simulation", nullptr, nullptr);
-    SDL_SetLogPriorities(SDL_LOG_PRIORITY_VERBOSE);
-    if (!SDL_Init(SDL_INIT_VIDEO))
+    for (int i = 1; i < argc; i++)
     {
-        SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
+        std::string_view arg = argv[i];
+        if (arg == "--record" && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (arg == "--replay-timing" && i + 1 < argc)
+        {
+            std::string_view timing = argv[++i];
+            if (timing == "fixed")
+            {
+                replayTiming = ReplayTiming::Fixed;
+            }
+            else if (timing == "original")
+            {
+                replayTiming = ReplayTiming::Original;
+            }
+            else
+            {
+                SDL_Log("Unknown replay timing: %s", timing.data());
+                return false;
+            }
+        }
+        else if (arg == "--stats" && i + 1 < argc)
+        {
+            statsPath = argv[++i];
+        }
+        else if (arg == "--benchmark" && i + 1 < argc)
+        {
+            benchmarkPath = argv[++i];
+        }
+        else if (arg == "--baseline" && i + 1 < argc)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (arg == "--threshold" && i + 1 < argc)
+        {
+            benchmarkThreshold = std::atof(argv[++i]);
+        }
+        else if (arg == "--repetitions" && i + 1 < argc)
+        {
+            benchmarkRepetitions = std::max(2, std::atoi(argv[++i]));
+        }
+        else if (arg == "--frames" && i + 1 < argc)
+        {
+            benchmarkFrames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--hud")
+        {
+            hudEnabled = true;
+        }
+        else if (arg == "--counters")
+        {
+            uniformBuffer.Counters = true;
+        }
+        else if (arg == "--telemetry" && i + 1 < argc)
+        {
+            telemetryPath = argv[++i];
+        }
+        else if (arg == "--telemetry-format" && i + 1 < argc)
+        {
+            std::string_view format = argv[++i];
+            if (format == "jsonl")
+            {
+                telemetryFormat = TelemetryFormat::Jsonl;
+            }
+            else if (format == "binary")
+            {
+                telemetryFormat = TelemetryFormat::Binary;
+            }
+            else
+            {
+                SDL_Log("Unknown telemetry format: %s", format.data());
+                return false;
+            }
+        }
+        else if (arg == "--telemetry-size" && i + 1 < argc)
+        {
+            telemetryBytes = std::max(1, std::atoi(argv[++i])) * uint64_t(1024 * 1024);
+        }
+        else if (arg == "--telemetry-files" && i + 1 < argc)
+        {
+            telemetryFiles = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--scene" && i + 1 < argc)
+        {
+            scenePath = argv[++i];
+        }
+        else if (arg == "--random-scene" && i + 1 < argc)
+        {
+            randomSceneCount = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--export-scene" && i + 1 < argc)
+        {
+            exportScenePath = argv[++i];
+        }
+        else if (arg == "--acceleration" && i + 1 < argc)
+        {
+            accelerationName = argv[++i];
+        }
+        else if (arg == "--environment" && i + 1 < argc)
+        {
+            environmentPath = argv[++i];
+        }
+        else if (arg == "--disk-cache" && i + 1 < argc)
+        {
+            diskCachePath = argv[++i];
+        }
+        else if (arg == "--stars" && i + 1 < argc)
+        {
+            catalogPath = argv[++i];
+        }
+        else if (arg == "--random-stars" && i + 1 < argc)
+        {
+            randomStarCount = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--lensing" && i + 1 < argc)
+        {
+            lensTolerance = std::atof(argv[++i]);
+        }
+        else if (arg == "--present-mode" && i + 1 < argc)
+        {
+            std::string_view mode = argv[++i];
+            if (mode == "vsync")
+            {
+                presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+            }
+            else if (mode == "mailbox")
+            {
+                presentMode = SDL_GPU_PRESENTMODE_MAILBOX;
+            }
+            else if (mode == "immediate")
+            {
+                presentMode = SDL_GPU_PRESENTMODE_IMMEDIATE;
+            }
+            else if (mode == "latency")
+            {
+                latencyFirst = true;
+            }
+            else
+            {
+                SDL_Log("Unknown present mode: %s", mode.data());
+                return false;
+            }
+        }
+        else if (arg == "--throughput" && i + 1 < argc)
+        {
+            throughputSeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--upscale" && i + 1 < argc)
+        {
+            std::string_view filter = argv[++i];
+            if (filter == "nearest")
+            {
+                upscaleFilter = UPSCALE_NEAREST;
+            }
+            else if (filter == "bilinear")
+            {
+                upscaleFilter = UPSCALE_BILINEAR;
+            }
+            else if (filter == "catmull-rom")
+            {
+                upscaleFilter = UPSCALE_CATMULL_ROM;
+            }
+            else
+            {
+                SDL_Log("Unknown upscale filter: %s", filter.data());
+                return false;
+            }
+        }
+        else if (arg == "--viewport" && i + 1 < argc)
+        {
+            Viewport viewport{};
+            if (std::sscanf(argv[++i], "%f,%f,%f", &viewport.Yaw, &viewport.Pitch, &viewport.Zoom) != 3 || viewport.Zoom <= 0.0f)
+            {
+                SDL_Log("Invalid viewport: %s", argv[i]);
+                return false;
+            }
+            viewports.push_back(viewport);
+        }
+        else if (arg == "--capture-file" && i + 1 < argc)
+        {
+            capturePath = argv[++i];
+        }
+        else if (arg == "--capture-size" && i + 1 < argc)
+        {
+            if (std::sscanf(argv[++i], "%ux%u", &captureWidth, &captureHeight) != 2 || !captureWidth || !captureHeight)
+            {
+                SDL_Log("Invalid capture size: %s", argv[i]);
+                return false;
+            }
+        }
+        else if (arg == "--capture-budget" && i + 1 < argc)
+        {
+            captureBudget = std::atof(argv[++i]);
+        }
+        else if (arg == "--frame-target" && i + 1 < argc)
+        {
+            frameTarget = std::atof(argv[++i]);
+        }
+        else if (arg == "--prefetch")
+        {
+            prefetchEnabled = true;
+        }
+        else if (arg == "--headless")
+        {
+            headless = true;
+        }
+        else if (arg == "--synthetic-input" && i + 1 < argc)
+        {
+            syntheticInputCount = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "--frames-in-flight" && i + 1 < argc)
+        {
+            framesInFlight = std::clamp(std::atoi(argv[++i]), 1, kFrames);
+        }
+        else if (arg == "--simulate")
+        {
+            simulate = true;
+        }
+        else if (arg == "--time-step" && i + 1 < argc)
+        {
+            simulationSettings.TimeStep = std::atof(argv[++i]);
+        }
+        else if (arg == "--time-scale" && i + 1 < argc)
+        {
+            simulationSettings.TimeScale = std::atof(argv[++i]);
+        }
+        else if (arg == "--theta" && i + 1 < argc)
+        {
+            simulationSettings.Theta = std::atof(argv[++i]);
+        }
+        else if (arg == "--simulate-benchmark" && i + 1 < argc)
+        {
+            simulationBenchmarkSteps = std::max(1, std::atoi(argv[++i]));
+        }
+        else
+        {
+            SDL_Log("Unknown argument: %s", arg.data());
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool LoadScene()
+{
+    if (scenePath)
+    {
+        return scene.Load(scenePath);
+    }
+    if (randomSceneCount)
+    {
+        scene.Load(CreateRandomScene(randomSceneCount, 0));
+    }
+    else
+    {
+        scene.Load(CreateDefaultScene());
+    }
+    return true;
+}
+
+static SDL_GPUBuffer* CreateBuffer(const void* data, uint32_t size, uint32_t capacity = 0)
+{
+    SDL_GPUBuffer* buffer;
+    {
+        SDL_GPUBufferCreateInfo info{};
+        info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ;
+        info.size = std::max({size, capacity, 16u});
+        buffer = SDL_CreateGPUBuffer(device, &info);
+        if (!buffer)
+        {
+            SDL_Log("Failed to create buffer: %s", SDL_GetError());
+            return nullptr;
+        }
+    }
+    if (!size)
+    {
+        return buffer;
+    }
+    SDL_GPUTransferBuffer* transferBuffer;
+    {
+        SDL_GPUTransferBufferCreateInfo info{};
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        info.size = std::min(size, kUploadChunk);
+        transferBuffer = SDL_CreateGPUTransferBuffer(device, &info);
+        if (!transferBuffer)
+        {
+            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+            SDL_ReleaseGPUBuffer(device, buffer);
+            return nullptr;
+        }
+    }
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    if (!commandBuffer)
+    {
+        SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        SDL_ReleaseGPUBuffer(device, buffer);
+        return nullptr;
+    }
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    if (!copyPass)
+    {
+        SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+        SDL_CancelGPUCommandBuffer(commandBuffer);
+        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        SDL_ReleaseGPUBuffer(device, buffer);
+        return nullptr;
+    }
+    /* NOTE: the transfer buffer is cycled so each chunk gets fresh memory without waiting on the previous upload */
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (uint32_t offset = 0; offset < size; offset += kUploadChunk)
+    {
+        uint32_t chunk = std::min(size - offset, kUploadChunk);
+        void* mapped = SDL_MapGPUTransferBuffer(device, transferBuffer, true);
+        if (!mapped)
+        {
+            SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+            SDL_EndGPUCopyPass(copyPass);
+            SDL_CancelGPUCommandBuffer(commandBuffer);
+            SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+            SDL_ReleaseGPUBuffer(device, buffer);
+            return nullptr;
+        }
+        std::memcpy(mapped, bytes + offset, chunk);
+        SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+        SDL_GPUTransferBufferLocation location{};
+        SDL_GPUBufferRegion region{};
+        location.transfer_buffer = transferBuffer;
+        region.buffer = buffer;
+        region.offset = offset;
+        region.size = chunk;
+        SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
+    }
+    SDL_EndGPUCopyPass(copyPass);
+    SDL_SubmitGPUCommandBuffer(commandBuffer);
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    return buffer;
+}
+
+static bool LoadObjects()
+{
+    if (!LoadScene())
+    {
+        return false;
+    }
+    uint64_t start = SDL_GetTicksNS();
+    std::string_view acceleration = accelerationName ? accelerationName : "";
+    if (acceleration == "linear")
+    {
+        uniformBuffer.Acceleration = ACCELERATION_LINEAR;
+    }
+    else if (acceleration == "bvh")
+    {
+        uniformBuffer.Acceleration = ACCELERATION_BVH;
+    }
+    else if (acceleration == "grid")
+    {
+        uniformBuffer.Acceleration = ACCELERATION_GRID;
+    }
+    else if (acceleration.empty())
+    {
+        uniformBuffer.Acceleration = scene.GetObjects().size() > kBvhThreshold ? ACCELERATION_BVH : ACCELERATION_LINEAR;
+    }
+    else
+    {
+        SDL_Log("Unknown acceleration: %s", acceleration.data());
         return false;
     }
-    window = SDL_CreateWindow("Black Hole Simulation", 960, 720, SDL_WINDOW_RESIZABLE);
-    if (!window)
+    /* NOTE: a mapped scene is read in place, a linear scene is quantized straight from it and a bvh scene
+     * is gathered into bvh order and snapped to the quantized positions in one pass */
+    InstanceSet instances;
+    GetInstanceBounds(scene.GetObjects(), instances);
+    std::vector<BvhNode> nodes;
+    Grid grid;
+    if (uniformBuffer.Acceleration != ACCELERATION_LINEAR)
+    {
+        /* NOTE: leaves index contiguous ranges so the objects are stored in bvh order */
+        std::vector<uint32_t> indices;
+        BuildBvh(scene.GetObjects(), nodes, indices);
+        std::vector<Object> objects(indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            objects[i] = scene.GetObjects()[indices[i]];
+            objects[i].Position = SnapPosition(objects[i].Position, instances);
+        }
+        scene.Load(std::move(objects));
+        /* NOTE: built on the unsnapped positions, refit so the bounds match the gpu */
+        RefitBvh(nodes, scene.GetObjects());
+        SDL_Log("Built bvh: %zu nodes in %.2fms", nodes.size(), (SDL_GetTicksNS() - start) / 1.0e6);
+    }
+    if (uniformBuffer.Acceleration == ACCELERATION_GRID && simulate)
+    {
+        /* NOTE: the grid is built once for static objects */
+        SDL_Log("Grid doesn't support moving objects, using bvh");
+        uniformBuffer.Acceleration = ACCELERATION_BVH;
+    }
+    if (uniformBuffer.Acceleration == ACCELERATION_GRID)
+    {
+        if (BuildGrid(scene.GetObjects(), nodes, grid))
+        {
+            uniformBuffer.GridInner = grid.Inner;
+            uniformBuffer.GridOuter = grid.Outer;
+            uniformBuffer.GridScale = GRID_SHELLS / std::log(grid.Outer / grid.Inner);
+            SDL_Log("Built grid: %zu references in %.2fms", grid.Indices.size(), (SDL_GetTicksNS() - start) / 1.0e6);
+        }
+        else
+        {
+            SDL_Log("Scene is too small for a grid, using bvh");
+            uniformBuffer.Acceleration = ACCELERATION_BVH;
+        }
+    }
+    std::span<const Object> objects = scene.GetObjects();
+    BuildInstances(objects, instances);
+    uniformBuffer.ObjectCount = objects.size();
+    uniformBuffer.InstanceMin = instances.Min;
+    uniformBuffer.InstanceScale = instances.Scale;
+    uniformBuffer.SceneRadius = GetInstanceRadius(instances);
+    /* NOTE: rebuilds while simulating can produce up to 2n - 1 nodes, prototypes keep their ids so each object
+     * adds at most its own and its swallowed one */
+    uint32_t nodeCapacity = simulate ? objects.size() * 2 * sizeof(BvhNode) : 0;
+    uint32_t prototypeCapacity = simulate ? objects.size() * 2 * sizeof(Prototype) : 0;
+    objectBuffer = CreateBuffer(instances.Instances.data(), instances.Instances.size() * sizeof(Instance));
+    prototypeBuffer = CreateBuffer(instances.Prototypes.data(), instances.Prototypes.size() * sizeof(Prototype), prototypeCapacity);
+    nodeBuffer = CreateBuffer(nodes.data(), nodes.size() * sizeof(BvhNode), nodeCapacity);
+    cellBuffer = CreateBuffer(grid.Cells.data(), grid.Cells.size() * sizeof(GridCell));
+    cellObjectBuffer = CreateBuffer(grid.Indices.data(), grid.Indices.size() * sizeof(uint32_t));
+    if (!objectBuffer || !prototypeBuffer || !nodeBuffer || !cellBuffer || !cellObjectBuffer)
     {
-        SDL_Log("Failed to create window: %s", SDL_GetError());
         return false;
     }
-#if defined(SDL_PLATFORM_WIN32)
-    device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_DXIL, true, nullptr);
-#elif defined(SDL_PLATFORM_APPLE)
-    device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_MSL, true, nullptr);
-#else
-    device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, true, nullptr);
-#endif
-    if (!device)
+    SDL_Log("Loaded %zu objects with %zu prototypes in %.2fms", objects.size(), instances.Prototypes.size(),
+        (SDL_GetTicksNS() - start) / 1.0e6);
+    if (!simulate)
+    {
+        return true;
+    }
+    if (!objectStream.Init(device, objectBuffer, std::as_bytes(std::span(instances.Instances)),
+            instances.Instances.size() * sizeof(Instance), sizeof(Instance)) ||
+        !prototypeStream.Init(device, prototypeBuffer, std::as_bytes(std::span(instances.Prototypes)), prototypeCapacity, sizeof(Prototype)) ||
+        !nodeStream.Init(device, nodeBuffer, std::as_bytes(std::span(nodes)), nodeCapacity, sizeof(BvhNode)))
     {
-        SDL_Log("Failed to create device: %s", SDL_GetError());
         return false;
     }
-    if (!SDL_ClaimWindowForGPUDevice(device, window))
+    return InitNBody(objects, simulationSettings);
+}
+
+static bool LoadSky()
+{
+    uint64_t start = SDL_GetTicksNS();
+    std::vector<CatalogStar> catalog;
+    if (catalogPath)
+    {
+        if (!LoadCatalog(catalogPath, catalog))
+        {
+            return false;
+        }
+    }
+    else if (randomStarCount)
+    {
+        catalog = CreateRandomCatalog(randomStarCount, 0);
+    }
+    Sky sky;
+    if (!catalog.empty())
+    {
+        BuildSky(catalog, sky);
+        SDL_Log("Built sky: %zu stars in %.2fms", sky.Stars.size(), (SDL_GetTicksNS() - start) / 1.0e6);
+    }
+    uniformBuffer.StarCount = sky.Stars.size();
+    std::vector<uint32_t> words;
+    PackSky(sky, words);
+    skyBuffer = CreateBuffer(words.data(), words.size() * sizeof(uint32_t));
+    return skyBuffer;
+}
+
+static bool LoadLenses()
+{
+    uint64_t start = SDL_GetTicksNS();
+    LensSet lenses;
+    if (lensTolerance > 0.0f && simulate)
+    {
+        /* NOTE: lenses are built once for static objects */
+        SDL_Log("Lensing doesn't support moving objects, disabling");
+    }
+    else if (lensTolerance > 0.0f)
+    {
+        BuildLenses(scene.GetObjects(), lensTolerance, lenses);
+        SDL_Log("Built lenses: %zu of %zu objects in %.2fms", lenses.Lenses.size(), scene.GetObjects().size(),
+            (SDL_GetTicksNS() - start) / 1.0e6);
+    }
+    uniformBuffer.LensCount = lenses.Lenses.size();
+    uniformBuffer.LensTolerance = lensTolerance;
+    if (!lenses.Nodes.empty())
+    {
+        /* NOTE: rays are still deflected anywhere inside an influence sphere so the early escape waits past them */
+        const BvhNode& root = lenses.Nodes[0];
+        float radius = glm::length(glm::max(glm::abs(root.Min), glm::abs(root.Max)));
+        uniformBuffer.SceneRadius = std::max(uniformBuffer.SceneRadius, radius);
+    }
+    lensBuffer = CreateBuffer(lenses.Lenses.data(), lenses.Lenses.size() * sizeof(Lens));
+    lensNodeBuffer = CreateBuffer(lenses.Nodes.data(), lenses.Nodes.size() * sizeof(BvhNode));
+    return lensBuffer && lensNodeBuffer;
+}
+
+static const char* GetPresentModeName(SDL_GPUPresentMode mode)
+{
+    switch (mode)
+    {
+    case SDL_GPU_PRESENTMODE_MAILBOX:
+        return "mailbox";
+    case SDL_GPU_PRESENTMODE_IMMEDIATE:
+        return "immediate";
+    default:
+        return "vsync";
+    }
+}
+
+static bool InitPresent()
+{
+    if (latencyFirst)
+    {
+        /* NOTE: mailbox never tears and never blocks, immediate never blocks, vsync is always supported */
+        presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+        for (SDL_GPUPresentMode mode : {SDL_GPU_PRESENTMODE_MAILBOX, SDL_GPU_PRESENTMODE_IMMEDIATE})
+        {
+            if (SDL_WindowSupportsGPUPresentMode(device, window, mode))
+            {
+                presentMode = mode;
+                break;
+            }
+        }
+        if (!framesInFlight)
+        {
+            framesInFlight = 1;
+        }
+    }
+    else if (!SDL_WindowSupportsGPUPresentMode(device, window, presentMode))
+    {
+        SDL_Log("Present mode isn't supported: %s, using vsync", GetPresentModeName(presentMode));
+        presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+    }
+    if (!framesInFlight)
+    {
+        framesInFlight = 2;
+    }
+    if (!SDL_SetGPUSwapchainParameters(device, window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, presentMode))
+    {
+        SDL_Log("Failed to set swapchain parameters: %s", SDL_GetError());
+        return false;
+    }
+    if (!SDL_SetGPUAllowedFramesInFlight(device, framesInFlight))
+    {
+        SDL_Log("Failed to set frames in flight: %s", SDL_GetError());
+        return false;
+    }
+    SDL_Log("Presenting with %s and %d frames in flight", GetPresentModeName(presentMode), framesInFlight);
+    return true;
+}
+
+static bool Init()
+{
+    SDL_SetAppMetadata("Black Hole Simulation", nullptr, nullptr);
+    SDL_SetLogPriorities(SDL_LOG_PRIORITY_VERBOSE);
+    /* NOTE: the disk is baked on a worker while the device and scene are set up */
+    BeginDisk(diskCachePath);
+    if (!SDL_Init(headless ? 0 : SDL_INIT_VIDEO))
+    {
+        SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
+        return false;
+    }
+    /* NOTE: headless runs never present so they need neither a window nor a swapchain */
+    if (!headless)
+    {
+        window = SDL_CreateWindow("Black Hole Simulation", 960, 720, SDL_WINDOW_RESIZABLE);
+        if (!window)
+        {
+            SDL_Log("Failed to create window: %s", SDL_GetError());
+            return false;
+        }
+    }
+#if defined(SDL_PLATFORM_WIN32)
+    device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_DXIL, true, nullptr);
+#elif defined(SDL_PLATFORM_APPLE)
+    device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_MSL, true, nullptr);
+#else
+    device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, true, nullptr);
+#endif
+    if (!device)
+    {
+        SDL_Log("Failed to create device: %s", SDL_GetError());
+        return false;
+    }
+    if (window)
+    {
+        if (!SDL_ClaimWindowForGPUDevice(device, window))
+        {
+            SDL_Log("Failed to create swapchain: %s", SDL_GetError());
+            return false;
+        }
+        if (!InitPresent())
+        {
+            return false;
+        }
+        if (!InitUpscale(device, window))
+        {
+            SDL_Log("Upscale pass isn't available, using a blit");
+            upscaleBlit = true;
+        }
+    }
+    /* NOTE: environment and disk, the storage buffers bound in Dispatch, the image, counters and ray states */
+    ComputeBindings bindings{};
+    bindings.Samplers = 2;
+    bindings.ReadonlyStorageBuffers = 8;
+    bindings.ReadwriteStorageTextures = 1;
+    bindings.ReadwriteStorageBuffers = 2;
+    bindings.UniformBuffers = 1;
+    geodesicPipeline = LoadComputePipeline(device, "geodesic.comp", bindings);
+    if (!geodesicPipeline)
+    {
+        SDL_Log("Failed to create pipeline");
+        return false;
+    }
+    {
+        SDL_GPUTextureCreateInfo info{};
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.usage = SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.width = WIDTH;
+        info.height = HEIGHT;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        colorTexture = SDL_CreateGPUTexture(device, &info);
+        if (!colorTexture)
+        {
+            SDL_Log("Failed to create texture: %s", SDL_GetError());
+            return false;
+        }
+    }
+    for (Viewport& viewport : viewports)
+    {
+        SDL_GPUTextureCreateInfo info{};
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.usage = SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.width = WIDTH / kInsetScale;
+        info.height = HEIGHT / kInsetScale;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        viewport.Texture = SDL_CreateGPUTexture(device, &info);
+        if (!viewport.Texture)
+        {
+            SDL_Log("Failed to create texture: %s", SDL_GetError());
+            return false;
+        }
+    }
+    if (!LoadObjects() || !LoadLenses() || !LoadSky() || !InitEnvironment(device, environmentPath) || !InitDisk(device))
+    {
+        return false;
+    }
+    {
+        SDL_GPUBufferCreateInfo info{};
+        info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+        info.size = COUNTER_COUNT * sizeof(uint32_t);
+        counterBuffer = SDL_CreateGPUBuffer(device, &info);
+        if (!counterBuffer)
+        {
+            SDL_Log("Failed to create buffer: %s", SDL_GetError());
+            return false;
+        }
+        info.size = WIDTH * HEIGHT * kRayStateSize;
+        rayStateBuffer = SDL_CreateGPUBuffer(device, &info);
+        if (!rayStateBuffer)
+        {
+            SDL_Log("Failed to create buffer: %s", SDL_GetError());
+            return false;
+        }
+    }
+    {
+        SDL_GPUTransferBufferCreateInfo info{};
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        info.size = COUNTER_COUNT * sizeof(uint32_t);
+        counterUploadBuffer = SDL_CreateGPUTransferBuffer(device, &info);
+        if (!counterUploadBuffer)
+        {
+            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+            return false;
+        }
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+        for (int i = 0; i < kFrames; i++)
+        {
+            counterDownloadBuffers[i] = SDL_CreateGPUTransferBuffer(device, &info);
+            if (!counterDownloadBuffers[i])
+            {
+                SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+                return false;
+            }
+        }
+    }
+    /* NOTE: the upload buffer is never written again so it's reused every frame to reset the counters */
+    uint32_t* counters = static_cast<uint32_t*>(SDL_MapGPUTransferBuffer(device, counterUploadBuffer, false));
+    if (!counters)
+    {
+        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    std::fill(counters, counters + COUNTER_COUNT, 0);
+    SDL_UnmapGPUTransferBuffer(device, counterUploadBuffer);
+    if (!InitHud(device))
+    {
+        SDL_Log("Failed to create hud");
+        return false;
+    }
+    return true;
+}
+
+/* NOTE: multiplicative, cutting at once when over the target and growing slowly under it so a zoom into the
+ * photon ring overshoots for no more than the frames already in flight */
+static void UpdateStepBudget(double ms)
+{
+    if (frameTarget <= 0.0 || ms <= 0.0)
+    {
+        return;
+    }
+    double scale = frameTarget / ms;
+    if (scale < 1.0)
+    {
+        maxSteps *= std::max(scale, 0.25);
+    }
+    else if (scale > 1.25)
+    {
+        maxSteps = maxSteps * 1.1 + 1;
+    }
+    maxSteps = std::clamp(maxSteps, kMinSteps, kMaxSteps);
+}
+
+static void ProcessFrame(int index)
+{
+    uint64_t time = SDL_GetTicksNS();
+    gpuTime = (time - submitTimes[index]) / 1.0e6;
+    /* NOTE: frames queued behind another only start once it completes */
+    UpdateStepBudget((time - std::max(submitTimes[index], completeTime)) / 1.0e6);
+    completeTime = time;
+    if (inputTimes[index])
+    {
+        completeLatencyStats.Add((time - inputTimes[index]) / 1.0e6);
+        if (!presentInputTime)
+        {
+            presentInputTime = inputTimes[index];
+        }
+        inputTimes[index] = 0;
+    }
+    if (countersPending[index])
+    {
+        uint32_t* counters = static_cast<uint32_t*>(SDL_MapGPUTransferBuffer(device, counterDownloadBuffers[index], false));
+        if (counters)
+        {
+            stepsPerPixel = double(counters[COUNTER_STEPS]) / (WIDTH * HEIGHT);
+            truncatedRays = counters[COUNTER_TRUNCATED];
+            SDL_UnmapGPUTransferBuffer(device, counterDownloadBuffers[index]);
+        }
+        countersPending[index] = false;
+    }
+    SDL_ReleaseGPUFence(device, fences[index]);
+    fences[index] = nullptr;
+}
+
+static void PollFrames()
+{
+    for (int i = 0; i < kFrames; i++)
+    {
+        if (fences[i] && SDL_QueryGPUFence(device, fences[i]))
+        {
+            ProcessFrame(i);
+        }
+    }
+}
+
+/* NOTE: the first swapchain image available after a frame completed, which approximates when the
+ * presentation engine took it and doesn't include scanout */
+static void StampPresent()
+{
+    if (presentInputTime)
+    {
+        presentLatencyStats.Add((SDL_GetTicksNS() - presentInputTime) / 1.0e6);
+        presentInputTime = 0;
+    }
+}
+
+/* NOTE: settles everything in flight before sleeping so no latency sample waits for the next input */
+static void FinishFrames()
+{
+    for (int i = 0; i < kFrames; i++)
+    {
+        if (fences[i])
+        {
+            SDL_WaitForGPUFences(device, true, &fences[i], 1);
+            ProcessFrame(i);
+        }
+    }
+    if (presentInputTime && SDL_WaitForGPUSwapchain(device, window))
+    {
+        StampPresent();
+    }
+}
+
+static void SubmitFrame(SDL_GPUCommandBuffer* commandBuffer)
+{
+    /* NOTE: completion is observed by polling so gpu time is an upper bound */
+    if (fences[frameIndex])
+    {
+        SDL_WaitForGPUFences(device, true, &fences[frameIndex], 1);
+        ProcessFrame(frameIndex);
+    }
+    submitTimes[frameIndex] = SDL_GetTicksNS();
+    fences[frameIndex] = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    if (!fences[frameIndex])
+    {
+        SDL_Log("Failed to submit command buffer: %s", SDL_GetError());
+        countersPending[frameIndex] = false;
+        return;
+    }
+    /* NOTE: the oldest input this frame is the first to show */
+    inputTimes[frameIndex] = inputTime;
+    inputTime = 0;
+    frameIndex = (frameIndex + 1) % framesInFlight;
+}
+
+static void Quit()
+{
+    QuitNBody();
+    if (window)
+    {
+        SDL_HideWindow(window);
+    }
+    for (int i = 0; i < kFrames; i++)
+    {
+        if (fences[i])
+        {
+            SDL_WaitForGPUFences(device, true, &fences[i], 1);
+            ProcessFrame(i);
+        }
+        SDL_ReleaseGPUTransferBuffer(device, counterDownloadBuffers[i]);
+    }
+    QuitHud(device);
+    QuitUpscale(device);
+    QuitPrefetch(device);
+    QuitDisk(device);
+    QuitEnvironment(device);
+    nodeStream.Quit(device);
+    prototypeStream.Quit(device);
+    objectStream.Quit(device);
+    SDL_ReleaseGPUTransferBuffer(device, counterUploadBuffer);
+    SDL_ReleaseGPUBuffer(device, rayStateBuffer);
+    SDL_ReleaseGPUBuffer(device, counterBuffer);
+    SDL_ReleaseGPUBuffer(device, lensNodeBuffer);
+    SDL_ReleaseGPUBuffer(device, lensBuffer);
+    SDL_ReleaseGPUBuffer(device, skyBuffer);
+    SDL_ReleaseGPUBuffer(device, cellObjectBuffer);
+    SDL_ReleaseGPUBuffer(device, cellBuffer);
+    SDL_ReleaseGPUBuffer(device, nodeBuffer);
+    SDL_ReleaseGPUBuffer(device, prototypeBuffer);
+    SDL_ReleaseGPUBuffer(device, objectBuffer);
+    for (Viewport& viewport : viewports)
+    {
+        SDL_ReleaseGPUTexture(device, viewport.Texture);
+    }
+    SDL_ReleaseGPUTransferBuffer(device, captureDownloadBuffer);
+    SDL_ReleaseGPUTexture(device, captureTexture);
+    SDL_ReleaseGPUTexture(device, colorTexture);
+    SDL_ReleaseGPUComputePipeline(device, geodesicPipeline);
+    if (window)
+    {
+        SDL_ReleaseWindowFromGPUDevice(device, window);
+    }
+    SDL_DestroyGPUDevice(device);
+    if (window)
+    {
+        SDL_DestroyWindow(window);
+    }
+    SDL_Quit();
+}
+
+static void UpdateUniforms(const CameraState& camera)
+{
+    uniformBuffer.TanHalfFov = std::tan(kFov * 0.5f);
+    uniformBuffer.Aspect = float(WIDTH) / HEIGHT;
+    uniformBuffer.CameraForward.x = std::cos(camera.Pitch) * std::cos(camera.Yaw);
+    uniformBuffer.CameraForward.y = std::sin(camera.Pitch);
+    uniformBuffer.CameraForward.z = std::cos(camera.Pitch) * std::sin(camera.Yaw);
+    uniformBuffer.CameraForward = glm::normalize(uniformBuffer.CameraForward);
+    uniformBuffer.CameraPosition = -uniformBuffer.CameraForward * camera.Distance;
+    uniformBuffer.CameraRight = glm::cross(uniformBuffer.CameraForward, glm::vec3(0.0f, 1.0f, 0.0f));
+    uniformBuffer.CameraRight = glm::normalize(uniformBuffer.CameraRight);
+    uniformBuffer.CameraUp = glm::cross(uniformBuffer.CameraRight, uniformBuffer.CameraForward);
+    uniformBuffer.CameraUp = glm::normalize(uniformBuffer.CameraUp);
+    uniformBuffer.MaxSteps = maxSteps;
+    uniformBuffer.Resume = RESUME_NONE;
+    uniformBuffer.CountTruncated = false;
+}
+
+static bool UploadSimulation(SDL_GPUCopyPass* copyPass)
+{
+    uploadFrameBytes = 0;
+    if (!GetNBody(simulationInstances, simulationNodes))
+    {
+        return true;
+    }
+    uint64_t start = SDL_GetTicksNS();
+    if (!objectStream.Upload(device, copyPass, std::as_bytes(std::span(simulationInstances.Instances))) ||
+        !prototypeStream.Upload(device, copyPass, std::as_bytes(std::span(simulationInstances.Prototypes))) ||
+        !nodeStream.Upload(device, copyPass, std::as_bytes(std::span(simulationNodes))))
+    {
+        return false;
+    }
+    uniformBuffer.InstanceMin = simulationInstances.Min;
+    uniformBuffer.InstanceScale = simulationInstances.Scale;
+    uniformBuffer.SceneRadius = GetInstanceRadius(simulationInstances);
+    uploadTime = (SDL_GetTicksNS() - start) / 1.0e6;
+    uploadFrameBytes = objectStream.GetUploadedBytes() + prototypeStream.GetUploadedBytes() + nodeStream.GetUploadedBytes();
+    uploadBytes += uploadFrameBytes;
+    uploadStats.Add(uploadTime);
+    return true;
+}
+
+static bool Dispatch(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTexture* texture, uint32_t width, uint32_t height)
+{
+    SDL_GPUStorageTextureReadWriteBinding readWriteTexture{};
+    SDL_GPUStorageBufferReadWriteBinding readWriteBuffers[2]{};
+    readWriteTexture.texture = texture;
+    readWriteBuffers[0].buffer = counterBuffer;
+    readWriteBuffers[1].buffer = rayStateBuffer;
+    SDL_GPUComputePass* computePass = SDL_BeginGPUComputePass(commandBuffer, &readWriteTexture, 1,
+        readWriteBuffers, SDL_arraysize(readWriteBuffers));
+    if (!computePass)
+    {
+        SDL_Log("Failed to begin compute pass: %s", SDL_GetError());
+        return false;
+    }
+    int groupsX = (width + THREADS - 1) / THREADS;
+    int groupsY = (height + THREADS - 1) / THREADS;
+    SDL_BindGPUComputePipeline(computePass, geodesicPipeline);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &uniformBuffer, sizeof(uniformBuffer));
+    SDL_GPUBuffer* storageBuffers[] =
+    {
+        objectBuffer, nodeBuffer, cellBuffer, cellObjectBuffer, prototypeBuffer, skyBuffer, lensBuffer, lensNodeBuffer,
+    };
+    SDL_BindGPUComputeStorageBuffers(computePass, 0, storageBuffers, SDL_arraysize(storageBuffers));
+    SDL_GPUTextureSamplerBinding samplers[] = {GetEnvironment(), GetDisk()};
+    SDL_BindGPUComputeSamplers(computePass, 0, samplers, SDL_arraysize(samplers));
+    SDL_DispatchGPUCompute(computePass, groupsX, groupsY, 1);
+    SDL_EndGPUComputePass(computePass);
+    return true;
+}
+
+static void ResetCounters(SDL_GPUCopyPass* copyPass)
+{
+    SDL_GPUTransferBufferLocation location{};
+    SDL_GPUBufferRegion region{};
+    location.transfer_buffer = counterUploadBuffer;
+    region.buffer = counterBuffer;
+    region.size = COUNTER_COUNT * sizeof(uint32_t);
+    SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
+}
+
+static bool DownloadCounters(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTransferBuffer* transferBuffer)
+{
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    if (!copyPass)
+    {
+        SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+        return false;
+    }
+    SDL_GPUBufferRegion region{};
+    SDL_GPUTransferBufferLocation location{};
+    region.buffer = counterBuffer;
+    region.size = COUNTER_COUNT * sizeof(uint32_t);
+    location.transfer_buffer = transferBuffer;
+    SDL_DownloadFromGPUBuffer(copyPass, &region, &location);
+    SDL_EndGPUCopyPass(copyPass);
+    return true;
+}
+
+/* NOTE: uploads, dispatch and counter readback of one frame, the caller submits on failure too */
+static bool Compute(SDL_GPUCommandBuffer* commandBuffer)
+{
+    UpdateUniforms(camera);
+    /* NOTE: the step budget needs the truncated ray count of every frame */
+    bool readCounters = uniformBuffer.Counters || frameTarget > 0.0;
+    if (frameTarget > 0.0 && !simulate)
+    {
+        uniformBuffer.Resume = resuming ? RESUME_CONTINUE : RESUME_STORE;
+    }
+    /* NOTE: only the main view counts truncated rays, insets, captures and prefetches don't */
+    uniformBuffer.CountTruncated = readCounters;
+    if (simulate || readCounters)
+    {
+        /* NOTE: recorded ahead of the dispatch in the same command buffer so the gpu orders them */
+        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+        if (!copyPass)
+        {
+            SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+            return false;
+        }
+        if (simulate && !UploadSimulation(copyPass))
+        {
+            SDL_EndGPUCopyPass(copyPass);
+            return false;
+        }
+        if (readCounters)
+        {
+            ResetCounters(copyPass);
+        }
+        SDL_EndGPUCopyPass(copyPass);
+    }
+    if (!Dispatch(commandBuffer, colorTexture, WIDTH, HEIGHT))
+    {
+        return false;
+    }
+    resumable = uniformBuffer.Resume != RESUME_NONE;
+    if (readCounters)
+    {
+        if (!DownloadCounters(commandBuffer, counterDownloadBuffers[frameIndex]))
+        {
+            return false;
+        }
+        countersPending[frameIndex] = true;
+    }
+    return true;
+}
+
+static void UpdateViewportCamera(Viewport& viewport)
+{
+    viewport.Camera = camera;
+    viewport.Camera.Yaw += glm::radians(viewport.Yaw);
+    viewport.Camera.Pitch = std::clamp(camera.Pitch + glm::radians(viewport.Pitch), -kClamp, kClamp);
+}
+
+/* NOTE: recorded after the main view in its command buffer so every view shares one upload, one submission
+ * and the same scene buffers, insets render at a fraction of the resolution */
+static bool DispatchViewports(SDL_GPUCommandBuffer* commandBuffer)
+{
+    /* NOTE: steps per pixel stay those of the main view, whose uniforms are restored after the insets */
+    UniformBuffer main = uniformBuffer;
+    uniformBuffer.Counters = 0;
+    bool dispatched = true;
+    for (Viewport& viewport : viewports)
+    {
+        UpdateViewportCamera(viewport);
+        UpdateUniforms(viewport.Camera);
+        uniformBuffer.TanHalfFov /= viewport.Zoom;
+        if (!Dispatch(commandBuffer, viewport.Texture, WIDTH / kInsetScale, HEIGHT / kInsetScale))
+        {
+            dispatched = false;
+            break;
+        }
+    }
+    uniformBuffer = main;
+    return dispatched;
+}
+
+/* NOTE: insets line the bottom right corner from right to left */
+static void DrawViewports(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTexture* swapchainTexture, uint32_t width, uint32_t height)
+{
+    uint32_t insetW = width / std::max<uint32_t>(kInsetSlots, viewports.size());
+    uint32_t insetH = insetW * HEIGHT / WIDTH;
+    for (uint32_t i = 0; i < viewports.size(); i++)
+    {
+        SDL_GPUBlitInfo info{};
+        info.load_op = SDL_GPU_LOADOP_LOAD;
+        info.source.texture = viewports[i].Texture;
+        info.source.w = WIDTH / kInsetScale;
+        info.source.h = HEIGHT / kInsetScale;
+        info.destination.texture = swapchainTexture;
+        info.destination.x = width - (i + 1) * insetW;
+        info.destination.y = height - insetH;
+        info.destination.w = insetW;
+        info.destination.h = insetH;
+        info.filter = SDL_GPU_FILTER_LINEAR;
+        SDL_BlitGPUTexture(commandBuffer, &info);
+    }
+}
+
+/* NOTE: prefetched is a finished frame for the camera, shown instead of computing one */
+static void Draw(SDL_GPUTexture* prefetched)
+{
+    PollFrames();
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    if (!commandBuffer)
+    {
+        SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
+        return;
+    }
+    SDL_GPUTexture* swapchainTexture;
+    uint32_t width;
+    uint32_t height;
+    if (!SDL_WaitAndAcquireGPUSwapchainTexture(commandBuffer, window, &swapchainTexture, &width, &height))
+    {
+        SDL_Log("Failed to acquire swapchain texture: %s", SDL_GetError());
+        SDL_CancelGPUCommandBuffer(commandBuffer);
+        return;
+    }
+    windowWidth = width;
+    windowHeight = height;
+    if (!swapchainTexture || !width || !height)
+    {
+        /* NOTE: not an error */
+        SDL_SubmitGPUCommandBuffer(commandBuffer);
+        return;
+    }
+    StampPresent();
+    /* NOTE: insets didn't change while resuming */
+    if ((!prefetched && !Compute(commandBuffer)) || (!resuming && !DispatchViewports(commandBuffer)))
+    {
+        SDL_SubmitGPUCommandBuffer(commandBuffer);
+        return;
+    }
+    SDL_GPUTexture* source = prefetched ? prefetched : colorTexture;
+    if (!DrawUpscale(commandBuffer, source, WIDTH, HEIGHT, swapchainTexture, width, height, upscaleFilter))
+    {
+        uint32_t letterboxW;
+        uint32_t letterboxH;
+        uint32_t letterboxX;
+        uint32_t letterboxY;
+        if ((static_cast<float>(WIDTH) / HEIGHT) > (static_cast<float>(width) / height))
+        {
+            letterboxW = width;
+            letterboxH = HEIGHT * static_cast<float>(width) / WIDTH;
+            letterboxX = 0.0f;
+            letterboxY = (height - letterboxH) / 2.0f;
+        }
+        else
+        {
+            letterboxH = height;
+            letterboxW = WIDTH * static_cast<float>(height) / HEIGHT;
+            letterboxX = (width - letterboxW) / 2.0f;
+            letterboxY = 0.0f;
+        }
+        SDL_FColor clearColor = {0.04f, 0.04f, 0.04f, 1.0f};
+        SDL_GPUBlitInfo info{};
+        info.load_op = SDL_GPU_LOADOP_CLEAR;
+        info.clear_color = clearColor;
+        info.source.texture = source;
+        info.source.w = WIDTH;
+        info.source.h = HEIGHT;
+        info.destination.texture = swapchainTexture;
+        info.destination.x = letterboxX;
+        info.destination.y = letterboxY;
+        info.destination.w = letterboxW;
+        info.destination.h = letterboxH;
+        info.filter = SDL_GPU_FILTER_NEAREST;
+        SDL_BlitGPUTexture(commandBuffer, &info);
+    }
+    DrawViewports(commandBuffer, swapchainTexture, width, height);
+    if (hudEnabled)
+    {
+        uint64_t time = SDL_GetTicksNS();
+        if (time - hudTime > kHudInterval)
+        {
+            hudTime = time;
+            hudLines.clear();
+            hudLines.push_back(std::format("FRAME P50 {:.2f} P95 {:.2f} P99 {:.2f} MS",
+                hudStats.Percentile(0.5), hudStats.Percentile(0.95), hudStats.Percentile(0.99)));
+            hudLines.push_back(std::format("GPU {:.2f} MS", gpuTime));
+            if (frameTarget > 0.0)
+            {
+                hudLines.push_back(std::format("MAX STEPS {} TRUNCATED {}", maxSteps, truncatedRays));
+            }
+            hudLines.push_back(std::format("PRESENT {} X{}", GetPresentModeName(presentMode), framesInFlight));
+            if (prefetchEnabled)
+            {
+                hudLines.push_back(std::format("PREFETCH {} HIT {} EXACT OF {}", prefetchHits, prefetchExactHits, prefetchFrames));
+            }
+            if (capturing)
+            {
+                uint32_t tiles = ((captureWidth + kCaptureTile - 1) / kCaptureTile) * ((captureHeight + kCaptureTile - 1) / kCaptureTile);
+                hudLines.push_back(std::format("CAPTURE {}% {:.2f} MS/TILE", captureTile * 100 / tiles, captureTileTime));
+            }
+            if (presentLatencyStats.Count())
+            {
+                hudLines.push_back(std::format("LATENCY GPU {:.2f} PRESENT {:.2f} MS",
+                    completeLatencyStats.Percentile(0.5), presentLatencyStats.Percentile(0.5)));
+            }
+            hudLines.push_back(std::format("RES {}X{} -> {}X{}{}", WIDTH, HEIGHT, width, height, upscaleBlit ? " BLIT" : ""));
+            if (uniformBuffer.Counters)
+            {
+                hudLines.push_back(std::format("STEPS/PX {:.0f}", stepsPerPixel));
+            }
+            else
+            {
+                hudLines.push_back("STEPS/PX OFF (F2)");
+            }
+            if (simulate)
+            {
+                hudLines.push_back(std::format("UPLOAD {:.1f} KB {:.2f} MS", uploadFrameBytes / 1024.0, uploadTime));
+            }
+            hudLines.push_back(std::format("PITCH {:.3f} YAW {:.3f}", camera.Pitch, camera.Yaw));
+            hudLines.push_back(std::format("DIST {:.3e} M", camera.Distance));
+        }
+        UpdateHud(device, commandBuffer, hudLines);
+        DrawHud(commandBuffer, swapchainTexture, width, height);
+    }
+    SubmitFrame(commandBuffer);
+}
+
+static bool RenderOffscreen(int frames)
+{
+    for (int i = 0; i < frames; i++)
+    {
+        SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+        if (!commandBuffer)
+        {
+            SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
+            return false;
+        }
+        UpdateUniforms(camera);
+        if (!Dispatch(commandBuffer, colorTexture, WIDTH, HEIGHT))
+        {
+            SDL_CancelGPUCommandBuffer(commandBuffer);
+            return false;
+        }
+        if (i + 1 < frames)
+        {
+            SDL_SubmitGPUCommandBuffer(commandBuffer);
+            continue;
+        }
+        SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+        if (!fence)
+        {
+            SDL_Log("Failed to submit command buffer: %s", SDL_GetError());
+            return false;
+        }
+        SDL_WaitForGPUFences(device, true, &fence, 1);
+        SDL_ReleaseGPUFence(device, fence);
+    }
+    return true;
+}
+
+/* NOTE: renders into the offscreen texture as fast as the fence ring allows, nothing is presented */
+static int RunThroughput()
+{
+    uint64_t duration = throughputSeconds * 1.0e9;
+    uint64_t start = 0;
+    uint64_t lastTime = 0;
+    int frames = 0;
+    for (int i = 0;; i++)
+    {
+        if (i == kThroughputWarmup)
+        {
+            FinishFrames();
+            start = SDL_GetTicksNS();
+            lastTime = start;
+        }
+        if (i > kThroughputWarmup && lastTime - start >= duration)
+        {
+            break;
+        }
+        SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+        if (!commandBuffer)
+        {
+            SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
+            return 1;
+        }
+        if (!Compute(commandBuffer) || !DispatchViewports(commandBuffer))
+        {
+            SDL_SubmitGPUCommandBuffer(commandBuffer);
+            return 1;
+        }
+        SubmitFrame(commandBuffer);
+        if (i >= kThroughputWarmup)
+        {
+            uint64_t time = SDL_GetTicksNS();
+            frameStats.Add((time - lastTime) / 1.0e6);
+            lastTime = time;
+            frames++;
+        }
+    }
+    FinishFrames();
+    double seconds = (SDL_GetTicksNS() - start) / 1.0e9;
+    double fps = frames / seconds;
+    double rays = WIDTH * HEIGHT + viewports.size() * (WIDTH / kInsetScale) * (HEIGHT / kInsetScale);
+    SDL_Log("Throughput: %d frames in %.2fs with %d in flight, %.1f fps, %.1f Mrays/s", frames, seconds, framesInFlight,
+        fps, fps * rays / 1.0e6);
+    if (uniformBuffer.Counters)
+    {
+        SDL_Log("Throughput: %.0f steps/px, %.2f Gsteps/s", stepsPerPixel, stepsPerPixel * WIDTH * HEIGHT * fps / 1.0e9);
+    }
+    frameStats.Log("Frame time");
+    if (statsPath && !SaveStats(statsPath, {{"frame_time", &frameStats}}))
+    {
+        return 1;
+    }
+    return 0;
+}
+
+static int RunBenchmark()
+{
+    std::vector<BenchmarkResult> results;
+    for (const BenchmarkView& view : GetBenchmarkViews())
+    {
+        camera.Pitch = view.Pitch;
+        camera.Yaw = view.Yaw;
+        camera.Distance = view.Distance;
+        if (!RenderOffscreen(benchmarkFrames))
+        {
+            return 1;
+        }
+        BenchmarkResult& result = results.emplace_back();
+        result.Name = view.Name;
+        for (int i = 0; i < benchmarkRepetitions; i++)
+        {
+            uint64_t start = SDL_GetTicksNS();
+            if (!RenderOffscreen(benchmarkFrames))
+            {
+                return 1;
+            }
+            result.Stats.Add((SDL_GetTicksNS() - start) / 1.0e6 / benchmarkFrames);
+        }
+        SDL_Log("%s: %.3fms +/- %.3f", view.Name, result.Stats.Mean(), result.Stats.Ci95());
+    }
+    if (!SaveBenchmark(benchmarkPath, results))
+    {
+        return 1;
+    }
+    if (baselinePath)
+    {
+        bool regressed;
+        if (!CompareBenchmark(baselinePath, results, benchmarkThreshold, &regressed))
+        {
+            return 1;
+        }
+        if (regressed)
+        {
+            SDL_Log("Significant regression against baseline: %s", baselinePath);
+            return 2;
+        }
+    }
+    return 0;
+}
+
+/* NOTE: a frame is only drawn when it could differ from the last one */
+static bool IsIdle()
+{
+    return !dirty && !simulate && !IsReplaying();
+}
+
+/* NOTE: returns whether the camera moved */
+static bool HandleInput(const SDL_Event& event, CameraState& state, glm::vec2& drag)
+{
+    switch (event.type)
+    {
+    case SDL_EVENT_MOUSE_WHEEL:
+        state.Distance = std::max(1.0f, state.Distance - event.wheel.y * kZoom);
+        return true;
+    case SDL_EVENT_MOUSE_MOTION:
+        if (event.motion.state & SDL_BUTTON_LMASK)
+        {
+            float pitch = state.Pitch;
+            state.Yaw += event.motion.xrel * kPan;
+            state.Pitch = std::clamp(state.Pitch + event.motion.yrel * kPan, -kClamp, kClamp);
+            drag = glm::vec2(event.motion.xrel * kPan, state.Pitch - pitch);
+            return true;
+        }
+        break;
+    }
+    return false;
+}
+
+static float GetRefreshRate()
+{
+    const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+    return mode ? mode->refresh_rate : 0.0f;
+}
+
+static void StartCapture()
+{
+    if (capturing)
     {
-        SDL_Log("Failed to create swapchain: %s", SDL_GetError());
-        return false;
+        SDL_Log("Capture is already running: %s", capturePath);
+        return;
     }
-    geodesicPipeline = LoadComputePipeline(device, "geodesic.comp");
-    if (!geodesicPipeline)
+    if (simulate)
     {
-        SDL_Log("Failed to create pipeline");
-        return false;
+        /* NOTE: tiles are rendered over many frames */
+        SDL_Log("Capture doesn't support moving objects");
+        return;
     }
+    if (!captureTexture)
     {
         SDL_GPUTextureCreateInfo info{};
         info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-        info.usage = SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        info.usage = SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE;
         info.type = SDL_GPU_TEXTURETYPE_2D;
-        info.width = WIDTH;
-        info.height = HEIGHT;
+        info.width = kCaptureTile;
+        info.height = kCaptureTile;
         info.layer_count_or_depth = 1;
         info.num_levels = 1;
-        colorTexture = SDL_CreateGPUTexture(device, &info);
-        if (!colorTexture)
+        captureTexture = SDL_CreateGPUTexture(device, &info);
+        if (!captureTexture)
         {
             SDL_Log("Failed to create texture: %s", SDL_GetError());
-            return false;
+            return;
         }
     }
-    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
-    if (!commandBuffer)
-    {
-        SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
-        return false;
-    }
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
-    if (!copyPass)
-    {
-        SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
-        return false;
-    }
-    uniformBuffer.ObjectCount = 3;
-    SDL_GPUTransferBuffer* transferBuffer;
+    if (!captureDownloadBuffer)
     {
         SDL_GPUTransferBufferCreateInfo info{};
-        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-        info.size = uniformBuffer.ObjectCount * sizeof(Object);
-        transferBuffer = SDL_CreateGPUTransferBuffer(device, &info);
-        if (!transferBuffer)
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+        info.size = kCaptureTile * kCaptureTile * 4;
+        captureDownloadBuffer = SDL_CreateGPUTransferBuffer(device, &info);
+        if (!captureDownloadBuffer)
         {
             SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
-            return false;
+            return;
         }
     }
-    Object* objects = static_cast<Object*>(SDL_MapGPUTransferBuffer(device, transferBuffer, false));
-    if (!objects)
+    if (!BeginCapture(capturePath, captureWidth, captureHeight))
     {
-        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
-        return false;
+        return;
     }
-    objects[0] = {{4e11f, 0.0f, 0.0f}, 4e10f, {1, 1, 0}, 1.98892e30f};
-    objects[1] = {{0.0f, 0.0f, 4e11f}, 4e10f, {1, 0, 0}, 1.98892e30f};
-    objects[2] = {{0.0f, 0.0f, 0.0f}, kBlackHoleRadius, {0, 0, 0}, kBlackHoleMass};
-    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    SDL_Log("Capturing %s: %ux%u", capturePath, captureWidth, captureHeight);
+    capturing = true;
+    captureCamera = camera;
+    captureTile = 0;
+    captureTileTime = 0.0;
+    captureStart = SDL_GetTicksNS();
+}
+
+static void UpdateInput()
+{
+    InputState state{};
+    if (inputSnapshot.Read(state))
     {
-        SDL_GPUBufferCreateInfo info{};
-        info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ;
-        info.size = uniformBuffer.ObjectCount * sizeof(Object);
-        objectBuffer = SDL_CreateGPUBuffer(device, &info);
-        if (!objectBuffer)
+        if (state.Hud != hudEnabled || state.Counters != uniformBuffer.Counters)
         {
-            SDL_Log("Failed to create buffer: %s", SDL_GetError());
-            return false;
+            hudTime = 0;
+        }
+        hudEnabled = state.Hud;
+        uniformBuffer.Counters = state.Counters;
+        refreshRate = state.RefreshRate;
+        /* NOTE: the replay owns the camera */
+        if (!IsReplaying())
+        {
+            camera = state.Camera;
+            drag = state.Drag;
+        }
+        resuming = false;
+        if (state.Captures != captureRequests)
+        {
+            captureRequests = state.Captures;
+            StartCapture();
         }
+        dirty = true;
     }
+    /* NOTE: the stamp comes with the snapshot so it can't belong to an input published after the read,
+     * clearing the pending stamp only succeeds once per input and later snapshots repeating it are ignored */
+    uint64_t expected = state.InputTime;
+    if (expected && pendingInputTime.compare_exchange_strong(expected, 0) && !inputTime)
     {
-        SDL_GPUTransferBufferLocation location{};
-        SDL_GPUBufferRegion region{};
-        location.transfer_buffer = transferBuffer;
-        region.buffer = objectBuffer;
-        region.size = uniformBuffer.ObjectCount * sizeof(Object);
-        SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
+        inputTime = state.InputTime;
     }
-    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(commandBuffer);
-    return true;
 }
 
-static void Draw()
+/* NOTE: runs on sdl's timer thread, the pushed events are stamped and handled like live ones */
+static Uint32 SDLCALL PushSyntheticInput(void* userdata, SDL_TimerID timer, Uint32 interval)
+{
+    static uint32_t count;
+    SDL_Event event{};
+    event.type = SDL_EVENT_MOUSE_MOTION;
+    event.common.timestamp = SDL_GetTicksNS();
+    event.motion.state = SDL_BUTTON_LMASK;
+    event.motion.xrel = count % 2 ? -kSyntheticStep : kSyntheticStep;
+    SDL_PushEvent(&event);
+    return ++count < syntheticInputCount ? interval : 0;
+}
+
+/* NOTE: the tile is a square window into the full capture, the offset of its centre from the image centre
+ * folds into the forward vector so the shader traces it like any other frame */
+static void UpdateCaptureUniforms(uint32_t x, uint32_t y)
+{
+    UpdateUniforms(captureCamera);
+    /* NOTE: captures aren't interactive so every ray gets the full budget */
+    uniformBuffer.MaxSteps = kMaxSteps;
+    float tanHalfFov = uniformBuffer.TanHalfFov;
+    float u = (2.0f * x + kCaptureTile - float(captureWidth)) * tanHalfFov / captureHeight;
+    float v = (float(captureHeight) - 2.0f * y - kCaptureTile) * tanHalfFov / captureHeight;
+    uniformBuffer.TanHalfFov = tanHalfFov * kCaptureTile / captureHeight;
+    uniformBuffer.Aspect = 1.0f;
+    uniformBuffer.CameraForward += u * uniformBuffer.CameraRight - v * uniformBuffer.CameraUp;
+}
+
+static bool RenderCaptureTile(uint32_t x, uint32_t y)
 {
     SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
     if (!commandBuffer)
     {
         SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
-        return;
+        return false;
     }
-    SDL_GPUTexture* swapchainTexture;
-    uint32_t width;
-    uint32_t height;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(commandBuffer, window, &swapchainTexture, &width, &height))
+    UpdateCaptureUniforms(x, y);
+    if (!Dispatch(commandBuffer, captureTexture, kCaptureTile, kCaptureTile))
     {
-        SDL_Log("Failed to acquire swapchain texture: %s", SDL_GetError());
         SDL_CancelGPUCommandBuffer(commandBuffer);
-        return;
+        return false;
     }
-    if (!swapchainTexture || !width || !height)
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    if (!copyPass)
     {
-        /* NOTE: not an error */
-        SDL_SubmitGPUCommandBuffer(commandBuffer);
-        return;
+        SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+        SDL_CancelGPUCommandBuffer(commandBuffer);
+        return false;
+    }
+    SDL_GPUTextureRegion region{};
+    SDL_GPUTextureTransferInfo info{};
+    region.texture = captureTexture;
+    region.w = kCaptureTile;
+    region.h = kCaptureTile;
+    region.d = 1;
+    info.transfer_buffer = captureDownloadBuffer;
+    SDL_DownloadFromGPUTexture(copyPass, &region, &info);
+    SDL_EndGPUCopyPass(copyPass);
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    if (!fence)
+    {
+        SDL_Log("Failed to submit command buffer: %s", SDL_GetError());
+        return false;
+    }
+    SDL_WaitForGPUFences(device, true, &fence, 1);
+    SDL_ReleaseGPUFence(device, fence);
+    const uint8_t* data = static_cast<const uint8_t*>(SDL_MapGPUTransferBuffer(device, captureDownloadBuffer, false));
+    if (!data)
+    {
+        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+        return false;
     }
+    bool written = WriteCapture(x, y, kCaptureTile, kCaptureTile, data, kCaptureTile * 4);
+    SDL_UnmapGPUTransferBuffer(device, captureDownloadBuffer);
+    return written;
+}
+
+/* NOTE: the frame time kept while capturing, one refresh interval unless given */
+static uint64_t GetCaptureBudget()
+{
+    if (captureBudget > 0.0)
     {
-        uniformBuffer.TanHalfFov = std::tan(kFov * 0.5f);
-        uniformBuffer.Aspect = float(WIDTH) / HEIGHT;
-        uniformBuffer.CameraForward.x = std::cos(pitch) * std::cos(yaw);
-        uniformBuffer.CameraForward.y = std::sin(pitch);
-        uniformBuffer.CameraForward.z = std::cos(pitch) * std::sin(yaw);
-        uniformBuffer.CameraForward = glm::normalize(uniformBuffer.CameraForward);
-        uniformBuffer.CameraPosition = -uniformBuffer.CameraForward * distance;
-        uniformBuffer.CameraRight = glm::cross(uniformBuffer.CameraForward, glm::vec3(0.0f, 1.0f, 0.0f));
-        uniformBuffer.CameraRight = glm::normalize(uniformBuffer.CameraRight);
-        uniformBuffer.CameraUp = glm::cross(uniformBuffer.CameraRight, uniformBuffer.CameraForward);
-        uniformBuffer.CameraUp = glm::normalize(uniformBuffer.CameraUp);
+        return captureBudget * 1.0e6;
     }
+    return 1.0e9 / (refreshRate > 0.0f ? refreshRate : 60.0f);
+}
+
+/* NOTE: renders capture tiles one at a time until the next one would likely end past the deadline, idle
+ * slices always make progress, interactive ones skip the capture when the frame left no room */
+static void StepCapture(uint64_t deadline, bool idle)
+{
+    uint32_t tilesX = (captureWidth + kCaptureTile - 1) / kCaptureTile;
+    uint32_t tilesY = (captureHeight + kCaptureTile - 1) / kCaptureTile;
+    uint32_t counters = uniformBuffer.Counters;
+    uniformBuffer.Counters = 0;
+    for (bool first = true; capturing && ((idle && first) || SDL_GetTicksNS() + captureTileTime * 1.0e6 <= deadline); first = false)
     {
-        SDL_GPUStorageTextureReadWriteBinding readWriteTexture{};
-        readWriteTexture.texture = colorTexture;
-        SDL_GPUComputePass* computePass = SDL_BeginGPUComputePass(commandBuffer, &readWriteTexture, 1, nullptr, 0);
-        if (!computePass)
+        uint64_t start = SDL_GetTicksNS();
+        if (!RenderCaptureTile(captureTile % tilesX * kCaptureTile, captureTile / tilesX * kCaptureTile))
         {
-            SDL_Log("Failed to begin compute pass: %s", SDL_GetError());
-            SDL_SubmitGPUCommandBuffer(commandBuffer);
-            return;
+            SDL_Log("Failed to capture: %s", capturePath);
+            EndCapture();
+            capturing = false;
+            break;
+        }
+        /* NOTE: a decaying maximum since tiles near the hole take many more steps than the sky */
+        captureTileTime = std::max((SDL_GetTicksNS() - start) / 1.0e6, captureTileTime * 0.9);
+        if (++captureTile == tilesX * tilesY)
+        {
+            capturing = false;
+            if (EndCapture())
+            {
+                SDL_Log("Captured %s: %ux%u in %.1fs", capturePath, captureWidth, captureHeight,
+                    (SDL_GetTicksNS() - captureStart) / 1.0e9);
+            }
         }
-        int groupsX = (WIDTH + THREADS - 1) / THREADS;
-        int groupsY = (HEIGHT + THREADS - 1) / THREADS;
-        SDL_BindGPUComputePipeline(computePass, geodesicPipeline);
-        SDL_PushGPUComputeUniformData(commandBuffer, 0, &uniformBuffer, sizeof(uniformBuffer));
-        SDL_BindGPUComputeStorageBuffers(computePass, 0, &objectBuffer, 1);
-        SDL_DispatchGPUCompute(computePass, groupsX, groupsY, 1);
-        SDL_EndGPUComputePass(computePass);
     }
+    uniformBuffer.Counters = counters;
+}
+
+/* NOTE: renders one likely next camera into the prefetch cache and waits for it so new input never
+ * queues behind more than one speculative frame, returns false once every guess is cached */
+static bool Prefetch()
+{
+    /* NOTE: one wheel notch either way, then the last drag event repeated */
+    CameraState guesses[3] = {camera, camera, camera};
+    guesses[0].Distance = std::max(1.0f, camera.Distance - kZoom);
+    guesses[1].Distance = std::max(1.0f, camera.Distance + kZoom);
+    guesses[2].Yaw += drag.x;
+    guesses[2].Pitch = std::clamp(camera.Pitch + drag.y, -kClamp, kClamp);
+    for (const CameraState& guess : guesses)
     {
-        uint32_t letterboxW;
-        uint32_t letterboxH;
-        uint32_t letterboxX;
-        uint32_t letterboxY;
-        if ((static_cast<float>(WIDTH) / HEIGHT) > (static_cast<float>(width) / height))
+        if (guess.Pitch == camera.Pitch && guess.Yaw == camera.Yaw && guess.Distance == camera.Distance)
         {
-            letterboxW = width;
-            letterboxH = HEIGHT * static_cast<float>(width) / WIDTH;
-            letterboxX = 0.0f;
-            letterboxY = (height - letterboxH) / 2.0f;
+            continue;
+        }
+        SDL_GPUTexture* texture = StorePrefetch(guess.Pitch, guess.Yaw, guess.Distance);
+        if (!texture)
+        {
+            continue;
+        }
+        SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+        if (!commandBuffer)
+        {
+            SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
+            ClearPrefetch();
+            return false;
+        }
+        UpdateUniforms(guess);
+        /* NOTE: idle means every frame finished, so the counters and the current download buffer are free */
+        uniformBuffer.CountTruncated = true;
+        bool dispatched = false;
+        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+        if (copyPass)
+        {
+            ResetCounters(copyPass);
+            SDL_EndGPUCopyPass(copyPass);
+            dispatched = Dispatch(commandBuffer, texture, WIDTH, HEIGHT) &&
+                DownloadCounters(commandBuffer, counterDownloadBuffers[frameIndex]);
         }
         else
         {
-            letterboxH = height;
-            letterboxW = WIDTH * static_cast<float>(height) / HEIGHT;
-            letterboxX = (width - letterboxW) / 2.0f;
-            letterboxY = 0.0f;
+            SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+        }
+        uniformBuffer.CountTruncated = false;
+        SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+        if (!fence)
+        {
+            SDL_Log("Failed to submit command buffer: %s", SDL_GetError());
+        }
+        if (!dispatched || !fence)
+        {
+            ClearPrefetch();
+            return false;
+        }
+        SDL_WaitForGPUFences(device, true, &fence, 1);
+        SDL_ReleaseGPUFence(device, fence);
+        uint32_t* counters = static_cast<uint32_t*>(SDL_MapGPUTransferBuffer(device, counterDownloadBuffers[frameIndex], false));
+        if (!counters || counters[COUNTER_TRUNCATED])
+        {
+            SetPrefetchTruncated(texture);
+        }
+        if (counters)
+        {
+            SDL_UnmapGPUTransferBuffer(device, counterDownloadBuffers[frameIndex]);
+        }
+        prefetchFrames++;
+        return true;
+    }
+    return false;
+}
+
+static void Stop()
+{
+    /* NOTE: wakes the event thread */
+    running = false;
+    SDL_Event event{};
+    event.type = SDL_EVENT_QUIT;
+    SDL_PushEvent(&event);
+}
+
+/* NOTE: owns the device after init, everything from the event thread arrives through the snapshot */
+static void Render()
+{
+    uint64_t startTime = SDL_GetTicksNS();
+    uint64_t lastTime = SDL_GetTicksNS();
+    while (running)
+    {
+        UpdateInput();
+        SDL_Event event;
+        while (PollReplay(frame, &event))
+        {
+            HandleInput(event, camera, drag);
+        }
+        if (IsIdle())
+        {
+            FinishFrames();
+            if (syntheticInputCount && syntheticInputs == syntheticInputCount)
+            {
+                /* NOTE: the count is raised after publishing so a last input not read yet shows up here */
+                UpdateInput();
+                if (!dirty)
+                {
+                    Stop();
+                }
+                continue;
+            }
+            if (resumable && truncatedRays)
+            {
+                /* NOTE: finishes the rays the last frame ran out of steps for, a budget at a time */
+                resuming = true;
+                dirty = true;
+                continue;
+            }
+            if (capturing)
+            {
+                StepCapture(SDL_GetTicksNS() + GetCaptureBudget(), true);
+            }
+            else if (!prefetchEnabled || !Prefetch())
+            {
+                inputSnapshot.Wait();
+            }
+            lastTime = SDL_GetTicksNS();
+            continue;
+        }
+        bool finished = IsReplayFinished();
+        SDL_GPUTexture* prefetched = nullptr;
+        bool exact = false;
+        if (prefetchEnabled && !refining && !resuming)
+        {
+            prefetched = FindPrefetch(camera.Pitch, camera.Yaw, camera.Distance, &exact);
+        }
+        if (prefetched)
+        {
+            prefetchHits++;
+            prefetchExactHits += exact;
+        }
+        /* NOTE: a frame for a nearby camera is shown now and the exact one computed right after */
+        refining = prefetched && !exact;
+        dirty = refining;
+        resumable = false;
+        Draw(prefetched);
+        resuming = false;
+        if (capturing)
+        {
+            StepCapture(lastTime + GetCaptureBudget(), false);
+        }
+        frame++;
+        uint64_t time = SDL_GetTicksNS();
+        if (IsReplaying() || statsPath)
+        {
+            frameStats.Add((time - lastTime) / 1.0e6);
+        }
+        hudStats.Add((time - lastTime) / 1.0e6);
+        if (telemetryPath)
+        {
+            TelemetryRecord record{};
+            record.Frame = frame;
+            record.Time = time - startTime;
+            record.FrameMs = (time - lastTime) / 1.0e6;
+            record.GpuMs = gpuTime;
+            record.Pitch = camera.Pitch;
+            record.Yaw = camera.Yaw;
+            record.Distance = camera.Distance;
+            record.RenderWidth = WIDTH;
+            record.RenderHeight = HEIGHT;
+            record.WindowWidth = windowWidth;
+            record.WindowHeight = windowHeight;
+            record.StepsPerPixel = uniformBuffer.Counters ? stepsPerPixel : 0.0f;
+            if (refreshRate > 0.0f)
+            {
+                float interval = 1000.0f / refreshRate;
+                record.DroppedFrames = std::max(0.0f, std::round(record.FrameMs / interval) - 1.0f);
+            }
+            WriteTelemetry(record);
+        }
+        if (hudStats.Count() > kHudFrames)
+        {
+            hudStats.Samples.erase(hudStats.Samples.begin());
+        }
+        lastTime = time;
+        if (finished)
+        {
+            Stop();
         }
-        SDL_FColor clearColor = {0.04f, 0.04f, 0.04f, 1.0f};
-        SDL_GPUBlitInfo info{};
-        info.load_op = SDL_GPU_LOADOP_CLEAR;
-        info.clear_color = clearColor;
-        info.source.texture = colorTexture;
-        info.source.w = WIDTH;
-        info.source.h = HEIGHT;
-        info.destination.texture = swapchainTexture;
-        info.destination.x = letterboxX;
-        info.destination.y = letterboxY;
-        info.destination.w = letterboxW;
-        info.destination.h = letterboxH;
-        info.filter = SDL_GPU_FILTER_NEAREST;
-        SDL_BlitGPUTexture(commandBuffer, &info);
     }
-    SDL_SubmitGPUCommandBuffer(commandBuffer);
 }
 
 int main(int argc, char** argv)
 {
-    if (!Init())
+    if (!ParseArgs(argc, argv))
     {
         return 1;
     }
-    bool running = true;
-    while (running)
+    if (exportScenePath)
     {
-        SDL_Event event;
-        while (SDL_PollEvent(&event))
+        if (!LoadScene() || !SaveScene(exportScenePath, scene.GetObjects()))
+        {
+            return 1;
+        }
+        return 0;
+    }
+    if (simulationBenchmarkSteps)
+    {
+        if (!LoadScene())
         {
-            switch (event.type)
+            return 1;
+        }
+        FrameStats stepStats;
+        for (double time : BenchmarkNBody(scene.GetObjects(), simulationSettings, simulationBenchmarkSteps))
+        {
+            stepStats.Add(time);
+        }
+        stepStats.Log("Simulation step");
+        SDL_Log("%zu bodies: %.1f steps/s", scene.GetObjects().size(), 1000.0 / stepStats.Mean());
+        if (statsPath)
+        {
+            SaveStats(statsPath, {{"simulation_step", &stepStats}});
+        }
+        return 0;
+    }
+    if (headless && !benchmarkPath && throughputSeconds <= 0.0)
+    {
+        SDL_Log("Headless needs --benchmark or --throughput");
+        return 1;
+    }
+    if (throughputSeconds > 0.0 && !framesInFlight)
+    {
+        framesInFlight = kFrames;
+    }
+    /* NOTE: every failure from here on has threads and gpu resources to release */
+    auto fail = []()
+    {
+        EndRecording();
+        EndReplay();
+        QuitTelemetry();
+        Quit();
+        return 1;
+    };
+    if (!Init())
+    {
+        return fail();
+    }
+    if (benchmarkPath)
+    {
+        int result = RunBenchmark();
+        Quit();
+        return result;
+    }
+    if (throughputSeconds > 0.0)
+    {
+        int result = RunThroughput();
+        Quit();
+        return result;
+    }
+    if (recordPath && !BeginRecording(recordPath))
+    {
+        return fail();
+    }
+    if (replayPath && !BeginReplay(replayPath, replayTiming))
+    {
+        return fail();
+    }
+    if (telemetryPath && !InitTelemetry(telemetryPath, telemetryFormat, telemetryBytes, telemetryFiles))
+    {
+        return fail();
+    }
+    if (prefetchEnabled && (simulate || replayPath))
+    {
+        /* NOTE: cached frames only stay valid while nothing but the camera moves */
+        SDL_Log("Prefetch doesn't support simulation or replays, disabling");
+        prefetchEnabled = false;
+    }
+    if (prefetchEnabled && !InitPrefetch(device, WIDTH, HEIGHT, kPan, kZoom * 0.01f))
+    {
+        return fail();
+    }
+    input.Camera = camera;
+    input.Hud = hudEnabled;
+    input.Counters = uniformBuffer.Counters;
+    input.RefreshRate = GetRefreshRate();
+    inputSnapshot.Publish(input);
+    running = true;
+    std::thread renderThread(Render);
+    SDL_TimerID syntheticTimer = 0;
+    if (syntheticInputCount)
+    {
+        syntheticTimer = SDL_AddTimer(kSyntheticInterval, PushSyntheticInput, nullptr);
+    }
+    SDL_Event event;
+    while (running && SDL_WaitEvent(&event))
+    {
+        switch (event.type)
+        {
+        case SDL_EVENT_MOUSE_WHEEL:
+        case SDL_EVENT_MOUSE_MOTION:
+            /* NOTE: live input is ignored while replaying to keep the trace deterministic */
+            if (!IsReplaying())
             {
-            case SDL_EVENT_MOUSE_WHEEL:
-                distance = std::max(1.0f, distance - event.wheel.y * kZoom);
-                break;
-            case SDL_EVENT_MOUSE_MOTION:
-                if (event.motion.state & SDL_BUTTON_LMASK)
+                RecordEvent(frame, event);
+                if (HandleInput(event, input.Camera, input.Drag))
                 {
-                    static constexpr float kClamp = glm::pi<float>() / 2.0f - 0.01f;
-                    yaw += event.motion.xrel * kPan;
-                    pitch = std::clamp(pitch + event.motion.yrel * kPan, -kClamp, kClamp);
+                    uint64_t expected = 0;
+                    pendingInputTime.compare_exchange_strong(expected, event.common.timestamp);
+                    input.InputTime = expected ? expected : event.common.timestamp;
+                    inputSnapshot.Publish(input);
+                    /* NOTE: counts every camera input, the mouse is expected to be left alone */
+                    if (syntheticInputCount)
+                    {
+                        syntheticInputs++;
+                    }
                 }
-                break;
-            case SDL_EVENT_QUIT:
-                running = false;
-                break;
             }
+            break;
+        case SDL_EVENT_KEY_DOWN:
+            if (event.key.key == SDLK_F1)
+            {
+                input.Hud = !input.Hud;
+                inputSnapshot.Publish(input);
+            }
+            else if (event.key.key == SDLK_F2)
+            {
+                input.Counters = !input.Counters;
+                inputSnapshot.Publish(input);
+            }
+            else if (event.key.key == SDLK_F12)
+            {
+                input.Captures++;
+                inputSnapshot.Publish(input);
+            }
+            break;
+        case SDL_EVENT_WINDOW_DISPLAY_CHANGED:
+            input.RefreshRate = GetRefreshRate();
+            inputSnapshot.Publish(input);
+            break;
+        case SDL_EVENT_WINDOW_EXPOSED:
+        case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+            inputSnapshot.Publish(input);
+            break;
+        case SDL_EVENT_QUIT:
+            running = false;
+            break;
         }
-        Draw();
     }
-    SDL_HideWindow(window);
-    SDL_ReleaseGPUBuffer(device, objectBuffer);
-    SDL_ReleaseGPUTexture(device, colorTexture);
-    SDL_ReleaseGPUComputePipeline(device, geodesicPipeline);
-    SDL_ReleaseWindowFromGPUDevice(device, window);
-    SDL_DestroyGPUDevice(device);
-    SDL_DestroyWindow(window);
-    SDL_Quit();
+    /* NOTE: wakes the render thread if it's idle */
+    running = false;
+    inputSnapshot.Publish(input);
+    renderThread.join();
+    if (syntheticTimer)
+    {
+        SDL_RemoveTimer(syntheticTimer);
+    }
+    EndRecording();
+    EndReplay();
+    QuitTelemetry();
+    if (capturing)
+    {
+        EndCapture();
+        SDL_Log("Capture was cancelled: %s", capturePath);
+    }
+    if (frameStats.Count())
+    {
+        frameStats.Log("Frame time");
+    }
+    if (completeLatencyStats.Count())
+    {
+        completeLatencyStats.Log("Input to completion");
+        completeLatencyStats.LogHistogram("Input to completion");
+    }
+    if (presentLatencyStats.Count())
+    {
+        presentLatencyStats.Log("Input to present");
+        presentLatencyStats.LogHistogram("Input to present");
+    }
+    if (uploadStats.Count())
+    {
+        uploadStats.Log("Upload time");
+        SDL_Log("Uploaded %.1f KB per update, %.1f MB/s while uploading", uploadBytes / 1024.0 / uploadStats.Count(),
+            uploadBytes / 1.0e3 / (uploadStats.Mean() * uploadStats.Count()));
+    }
+    if (prefetchEnabled)
+    {
+        SDL_Log("Prefetched %" SDL_PRIu64 " frames, %" SDL_PRIu64 " hits, %" SDL_PRIu64 " exact", prefetchFrames,
+            prefetchHits, prefetchExactHits);
+    }
+    if (statsPath)
+    {
+        SaveStats(statsPath, {{"frame_time", &frameStats}, {"upload_time", &uploadStats},
+            {"input_to_complete", &completeLatencyStats}, {"input_to_present", &presentLatencyStats}});
+    }
+    Quit();
     return 0;
 }
\ No newline at end of file
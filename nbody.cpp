@@ -0,0 +1,590 @@
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "bvh.hpp"
+#include "instance.hpp"
+#include "nbody.hpp"
+#include "scene.hpp"
+
+static constexpr double kCentralMass = kBlackHoleMass;
+static constexpr double kHorizon = kBlackHoleRadius;
+static constexpr uint32_t kLeafSize = 8;
+static constexpr int kDepth = 32;
+static constexpr uint32_t kChunk = 256;
+static constexpr int kCatchUp = 8;
+static constexpr int kRebuild = 32;
+static constexpr float kPadding = 0.25f;
+static constexpr int kSplitDepth = 2;
+
+/* NOTE: barnes-hut octree cell, children are contiguous and a leaf has no children */
+struct Cell
+{
+    glm::dvec3 Center;
+    double Mass;
+    glm::dvec3 Origin;
+    double Size;
+    uint32_t Child;
+    uint32_t ChildCount;
+    uint32_t Begin;
+    uint32_t Count;
+};
+
+/* NOTE: double precision state in bvh order, objects mirror it snapped to the quantized instance positions */
+struct System
+{
+    NBodySettings Settings;
+    std::vector<Object> Objects;
+    std::vector<glm::dvec3> Positions;
+    std::vector<glm::dvec3> Velocities;
+    std::vector<glm::dvec3> Accelerations;
+    std::vector<double> Masses;
+    std::vector<uint8_t> Fixed;
+    std::vector<uint32_t> Order;
+    std::vector<Cell> Cells;
+    std::vector<BvhNode> Nodes;
+    InstanceSet Instances;
+    int Publishes;
+};
+
+/* NOTE: workers live as long as the simulation and wake for each parallel loop, the caller joins in */
+struct Pool
+{
+    std::vector<std::thread> Threads;
+    std::mutex Mutex;
+    std::condition_variable Start;
+    std::condition_variable Done;
+    const std::function<void(uint32_t, uint32_t)>* Function;
+    uint32_t Count;
+    uint32_t Chunk;
+    std::atomic<uint32_t> Next;
+    uint32_t Generation;
+    uint32_t Busy;
+    bool Stopping;
+};
+
+/* NOTE: a subtree left for the workers, built into its own cells and spliced in afterwards */
+struct Subtree
+{
+    uint32_t Index;
+    uint32_t Begin;
+    uint32_t End;
+    int Depth;
+    std::vector<Cell> Cells;
+};
+
+static Pool pool;
+static System simulation;
+static InstanceSet publishedInstances;
+static std::vector<BvhNode> publishedNodes;
+static bool published;
+static std::atomic<bool> running;
+static std::thread thread;
+static std::mutex mutex;
+static std::condition_variable condition;
+
+static void RunChunks()
+{
+    while (true)
+    {
+        uint32_t begin = pool.Next.fetch_add(pool.Chunk);
+        if (begin >= pool.Count)
+        {
+            break;
+        }
+        (*pool.Function)(begin, std::min(begin + pool.Chunk, pool.Count));
+    }
+}
+
+static void Work(uint32_t generation)
+{
+    std::unique_lock lock(pool.Mutex);
+    while (true)
+    {
+        pool.Start.wait(lock, [&]() { return pool.Stopping || pool.Generation != generation; });
+        if (pool.Stopping)
+        {
+            return;
+        }
+        generation = pool.Generation;
+        lock.unlock();
+        RunChunks();
+        lock.lock();
+        if (!--pool.Busy)
+        {
+            pool.Done.notify_one();
+        }
+    }
+}
+
+static void StartPool()
+{
+    pool.Stopping = false;
+    unsigned concurrency = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 1; i < concurrency; i++)
+    {
+        pool.Threads.emplace_back(Work, pool.Generation);
+    }
+}
+
+static void StopPool()
+{
+    {
+        std::lock_guard lock(pool.Mutex);
+        pool.Stopping = true;
+    }
+    pool.Start.notify_all();
+    for (std::thread& thread : pool.Threads)
+    {
+        thread.join();
+    }
+    pool.Threads.clear();
+}
+
+/* NOTE: calls function over [0, count) in chunks spread over the pool, returns once every chunk is done */
+static void ForEach(uint32_t count, uint32_t chunk, const std::function<void(uint32_t, uint32_t)>& function)
+{
+    if (count <= chunk || pool.Threads.empty())
+    {
+        function(0, count);
+        return;
+    }
+    {
+        std::lock_guard lock(pool.Mutex);
+        pool.Function = &function;
+        pool.Count = count;
+        pool.Chunk = chunk;
+        pool.Next = 0;
+        pool.Busy = pool.Threads.size();
+        pool.Generation++;
+    }
+    pool.Start.notify_all();
+    RunChunks();
+    std::unique_lock lock(pool.Mutex);
+    pool.Done.wait(lock, [&]() { return !pool.Busy; });
+}
+
+/* NOTE: cells below kSplitDepth are deferred to subtrees when given somewhere to put them */
+static void BuildCell(System& system, std::vector<Cell>& cells, uint32_t index, uint32_t begin, uint32_t end, int depth,
+    std::vector<Subtree>* subtrees)
+{
+    if (subtrees && depth == kSplitDepth)
+    {
+        subtrees->push_back({index, begin, end, depth, {cells[index]}});
+        return;
+    }
+    glm::dvec3 center{0.0};
+    double mass = 0.0;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        uint32_t body = system.Order[i];
+        center += system.Positions[body] * system.Masses[body];
+        mass += system.Masses[body];
+    }
+    Cell& cell = cells[index];
+    cell.Center = mass > 0.0 ? center / mass : cell.Origin;
+    cell.Mass = mass;
+    cell.Child = 0;
+    cell.ChildCount = 0;
+    cell.Begin = begin;
+    cell.Count = end - begin;
+    if (end - begin <= kLeafSize || depth >= kDepth)
+    {
+        return;
+    }
+    /* NOTE: three nested partitions split the range into octants ordered by (x, y, z) */
+    glm::dvec3 origin = cell.Origin;
+    double size = cell.Size;
+    std::array<uint32_t, 9> bounds;
+    bounds[0] = begin;
+    bounds[8] = end;
+    uint32_t* order = system.Order.data();
+    auto split = [&](uint32_t first, uint32_t last, int axis)
+    {
+        return uint32_t(std::partition(order + first, order + last, [&](uint32_t body)
+        {
+            return system.Positions[body][axis] < origin[axis];
+        }) - order);
+    };
+    bounds[4] = split(bounds[0], bounds[8], 0);
+    bounds[2] = split(bounds[0], bounds[4], 1);
+    bounds[6] = split(bounds[4], bounds[8], 1);
+    for (int i = 0; i < 8; i += 2)
+    {
+        bounds[i + 1] = split(bounds[i], bounds[i + 2], 2);
+    }
+    uint32_t child = cells.size();
+    uint32_t childCount = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        childCount += bounds[i + 1] > bounds[i];
+    }
+    cells.resize(child + childCount);
+    cells[index].Child = child;
+    cells[index].ChildCount = childCount;
+    for (int i = 0, next = child; i < 8; i++)
+    {
+        if (bounds[i + 1] <= bounds[i])
+        {
+            continue;
+        }
+        glm::dvec3 offset{i & 4 ? 0.5 : -0.5, i & 2 ? 0.5 : -0.5, i & 1 ? 0.5 : -0.5};
+        cells[next].Origin = origin + offset * size;
+        cells[next].Size = size * 0.5;
+        BuildCell(system, cells, next, bounds[i], bounds[i + 1], depth + 1, subtrees);
+        next++;
+    }
+}
+
+static void BuildTree(System& system)
+{
+    system.Order.clear();
+    system.Cells.clear();
+    glm::dvec3 min{std::numeric_limits<double>::max()};
+    glm::dvec3 max{-std::numeric_limits<double>::max()};
+    for (uint32_t i = 0; i < system.Positions.size(); i++)
+    {
+        if (system.Masses[i] > 0.0)
+        {
+            system.Order.push_back(i);
+            min = glm::min(min, system.Positions[i]);
+            max = glm::max(max, system.Positions[i]);
+        }
+    }
+    if (system.Order.empty())
+    {
+        return;
+    }
+    Cell& root = system.Cells.emplace_back();
+    root.Origin = (min + max) * 0.5;
+    root.Size = std::max({max.x - min.x, max.y - min.y, max.z - min.z, 1.0}) * 0.5;
+    /* NOTE: the top levels are split serially, the subtrees under them partition disjoint ranges in parallel */
+    std::vector<Subtree> subtrees;
+    BuildCell(system, system.Cells, 0, 0, system.Order.size(), 0, &subtrees);
+    ForEach(subtrees.size(), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            Subtree& subtree = subtrees[i];
+            BuildCell(system, subtree.Cells, 0, subtree.Begin, subtree.End, subtree.Depth, nullptr);
+        }
+    });
+    for (const Subtree& subtree : subtrees)
+    {
+        /* NOTE: the subtree root replaces its placeholder and the rest is appended, so children shift by the
+         * offset of the append minus the root */
+        uint32_t shift = system.Cells.size() - 1;
+        for (uint32_t i = 0; i < subtree.Cells.size(); i++)
+        {
+            Cell cell = subtree.Cells[i];
+            if (cell.ChildCount)
+            {
+                cell.Child += shift;
+            }
+            if (i)
+            {
+                system.Cells.push_back(cell);
+            }
+            else
+            {
+                system.Cells[subtree.Index] = cell;
+            }
+        }
+    }
+}
+
+static glm::dvec3 GetAcceleration(const System& system, uint32_t body)
+{
+    static constexpr double kG64 = kG;
+    glm::dvec3 position = system.Positions[body];
+    double softening = system.Settings.Softening * system.Settings.Softening;
+    double theta = system.Settings.Theta * system.Settings.Theta;
+    double r2 = glm::dot(position, position) + softening;
+    glm::dvec3 acceleration = -position * (kG64 * kCentralMass / (r2 * std::sqrt(r2)));
+    if (system.Cells.empty())
+    {
+        return acceleration;
+    }
+    std::array<uint32_t, 8 * kDepth + 8> stack;
+    int count = 0;
+    stack[count++] = 0;
+    while (count > 0)
+    {
+        const Cell& cell = system.Cells[stack[--count]];
+        if (!cell.ChildCount)
+        {
+            for (uint32_t i = cell.Begin; i < cell.Begin + cell.Count; i++)
+            {
+                uint32_t other = system.Order[i];
+                if (other == body)
+                {
+                    continue;
+                }
+                glm::dvec3 d = system.Positions[other] - position;
+                double r2 = glm::dot(d, d) + softening;
+                acceleration += d * (kG64 * system.Masses[other] / (r2 * std::sqrt(r2)));
+            }
+            continue;
+        }
+        glm::dvec3 d = cell.Center - position;
+        double r2 = glm::dot(d, d) + softening;
+        if (4.0 * cell.Size * cell.Size < theta * r2)
+        {
+            acceleration += d * (kG64 * cell.Mass / (r2 * std::sqrt(r2)));
+            continue;
+        }
+        for (uint32_t i = 0; i < cell.ChildCount; i++)
+        {
+            stack[count++] = cell.Child + i;
+        }
+    }
+    return acceleration;
+}
+
+static void UpdateAccelerations(System& system)
+{
+    BuildTree(system);
+    ForEach(system.Positions.size(), kChunk, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (!system.Fixed[i])
+            {
+                system.Accelerations[i] = GetAcceleration(system, i);
+            }
+        }
+    });
+}
+
+/* NOTE: kick-drift-kick leapfrog, symplectic for a fixed timestep */
+static void Step(System& system)
+{
+    double dt = system.Settings.TimeStep;
+    ForEach(system.Positions.size(), kChunk, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (!system.Fixed[i])
+            {
+                system.Velocities[i] += system.Accelerations[i] * (dt * 0.5);
+                system.Positions[i] += system.Velocities[i] * dt;
+            }
+        }
+    });
+    UpdateAccelerations(system);
+    ForEach(system.Positions.size(), kChunk, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            if (system.Fixed[i])
+            {
+                continue;
+            }
+            system.Velocities[i] += system.Accelerations[i] * (dt * 0.5);
+            if (glm::dot(system.Positions[i], system.Positions[i]) < kHorizon * kHorizon)
+            {
+                /* NOTE: swallowed by the hole, stops contributing and is no longer drawn */
+                system.Fixed[i] = true;
+                system.Masses[i] = 0.0;
+                system.Objects[i].Radius = 0.0f;
+            }
+        }
+    });
+}
+
+template <typename T>
+static void Permute(std::vector<T>& values, const std::vector<uint32_t>& indices)
+{
+    std::vector<T> permuted;
+    permuted.reserve(values.size());
+    for (uint32_t index : indices)
+    {
+        permuted.push_back(values[index]);
+    }
+    values = std::move(permuted);
+}
+
+static void UpdateObjects(System& system)
+{
+    for (uint32_t i = 0; i < system.Objects.size(); i++)
+    {
+        system.Objects[i].Position = glm::vec3(system.Positions[i]);
+    }
+    /* NOTE: the bounds stay pinned while every body is inside them, requantizing moves every instance and
+     * turns the next upload into a full one */
+    if (!system.Publishes || !ContainsInstances(system.Objects, system.Instances))
+    {
+        GetInstanceBounds(system.Objects, system.Instances, kPadding);
+    }
+    for (Object& object : system.Objects)
+    {
+        object.Position = SnapPosition(object.Position, system.Instances);
+    }
+    /* NOTE: refitting is cheap but bounds loosen as bodies shear apart, so rebuild periodically */
+    if (system.Publishes++ % kRebuild)
+    {
+        RefitBvh(system.Nodes, system.Objects);
+        BuildInstances(system.Objects, system.Instances);
+        return;
+    }
+    std::vector<uint32_t> indices;
+    BuildBvh(system.Objects, system.Nodes, indices);
+    Permute(system.Objects, indices);
+    Permute(system.Positions, indices);
+    Permute(system.Velocities, indices);
+    Permute(system.Accelerations, indices);
+    Permute(system.Masses, indices);
+    Permute(system.Fixed, indices);
+    BuildInstances(system.Objects, system.Instances);
+}
+
+static void Init(System& system, std::span<const Object> objects, const NBodySettings& settings)
+{
+    system.Settings = settings;
+    system.Objects.assign(objects.begin(), objects.end());
+    system.Positions.resize(objects.size());
+    system.Velocities.resize(objects.size());
+    system.Accelerations.assign(objects.size(), glm::dvec3{0.0});
+    system.Masses.resize(objects.size());
+    system.Fixed.resize(objects.size());
+    system.Publishes = 0;
+    for (uint32_t i = 0; i < objects.size(); i++)
+    {
+        glm::dvec3 position{objects[i].Position};
+        double r = glm::length(position);
+        system.Positions[i] = position;
+        system.Masses[i] = objects[i].Mass;
+        system.Fixed[i] = r <= kHorizon;
+        if (system.Fixed[i])
+        {
+            /* NOTE: bodies standing in for the hole itself are already the central mass */
+            system.Masses[i] = 0.0;
+            system.Velocities[i] = glm::dvec3{0.0};
+            continue;
+        }
+        /* NOTE: start on circular orbits about the hole in the plane of the disk */
+        glm::dvec3 direction = glm::cross(glm::dvec3{0.0, 1.0, 0.0}, position);
+        if (glm::dot(direction, direction) < 1.0e-6 * r * r)
+        {
+            direction = glm::dvec3{1.0, 0.0, 0.0};
+        }
+        system.Velocities[i] = glm::normalize(direction) * std::sqrt(double(kG) * kCentralMass / r);
+    }
+    UpdateAccelerations(system);
+    UpdateObjects(system);
+}
+
+static void Publish()
+{
+    UpdateObjects(simulation);
+    std::lock_guard lock(mutex);
+    publishedInstances = simulation.Instances;
+    publishedNodes = simulation.Nodes;
+    published = true;
+}
+
+static void Run()
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point last = Clock::now();
+    double pending = 0.0;
+    double dt = simulation.Settings.TimeStep;
+    while (running)
+    {
+        Clock::time_point now = Clock::now();
+        pending += std::chrono::duration<double>(now - last).count() * simulation.Settings.TimeScale;
+        last = now;
+        int steps = 0;
+        while (pending >= dt && steps < kCatchUp)
+        {
+            Step(simulation);
+            pending -= dt;
+            steps++;
+        }
+        if (steps == kCatchUp)
+        {
+            /* NOTE: can't keep up so simulated time slows down instead of spiralling */
+            pending = 0.0;
+        }
+        if (steps)
+        {
+            Publish();
+            continue;
+        }
+        std::unique_lock lock(mutex);
+        condition.wait_for(lock, std::chrono::duration<double>((dt - pending) / simulation.Settings.TimeScale));
+    }
+}
+
+bool InitNBody(std::span<const Object> objects, const NBodySettings& settings)
+{
+    if (objects.empty() || settings.TimeStep <= 0.0 || settings.TimeScale <= 0.0)
+    {
+        SDL_Log("Failed to initialize simulation: no objects or invalid timestep");
+        return false;
+    }
+    StartPool();
+    Init(simulation, objects, settings);
+    publishedInstances = simulation.Instances;
+    publishedNodes = simulation.Nodes;
+    published = true;
+    running = true;
+    thread = std::thread(Run);
+    return true;
+}
+
+bool GetNBody(InstanceSet& instances, std::vector<BvhNode>& nodes)
+{
+    std::lock_guard lock(mutex);
+    if (!published)
+    {
+        return false;
+    }
+    std::swap(instances, publishedInstances);
+    std::swap(nodes, publishedNodes);
+    published = false;
+    return true;
+}
+
+void QuitNBody()
+{
+    if (!running)
+    {
+        return;
+    }
+    running = false;
+    condition.notify_one();
+    thread.join();
+    StopPool();
+}
+
+std::vector<double> BenchmarkNBody(std::span<const Object> objects, const NBodySettings& settings, int steps)
+{
+    using Clock = std::chrono::steady_clock;
+    System system;
+    StartPool();
+    Init(system, objects, settings);
+    std::vector<double> times;
+    for (int i = 0; i < steps; i++)
+    {
+        Clock::time_point start = Clock::now();
+        Step(system);
+        UpdateObjects(system);
+        times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    StopPool();
+    return times;
+}
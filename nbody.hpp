@@ -0,0 +1,24 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "bvh.hpp"
+#include "instance.hpp"
+#include "scene.hpp"
+
+struct NBodySettings
+{
+    double TimeStep = 10.0;
+    double TimeScale = 1000.0;
+    double Theta = 0.5;
+    double Softening = 1.0e9;
+};
+
+/* NOTE: objects are reordered into bvh order, published nodes index the published instances */
+bool InitNBody(std::span<const Object> objects, const NBodySettings& settings);
+bool GetNBody(InstanceSet& instances, std::vector<BvhNode>& nodes);
+void QuitNBody();
+
+/* NOTE: runs synchronously on the calling thread and returns the milliseconds taken by each step */
+std::vector<double> BenchmarkNBody(std::span<const Object> objects, const NBodySettings& settings, int steps);
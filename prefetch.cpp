@@ -0,0 +1,137 @@
+#include <SDL3/SDL.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "prefetch.hpp"
+
+static constexpr int kSlots = 4;
+
+struct CameraKey
+{
+    int32_t Pitch;
+    int32_t Yaw;
+    int32_t Distance;
+
+    bool operator==(const CameraKey& other) const = default;
+};
+
+struct Entry
+{
+    SDL_GPUTexture* Texture;
+    bool Valid;
+    CameraKey Key;
+    float Pitch;
+    float Yaw;
+    float Distance;
+    bool Truncated;
+    uint64_t Use;
+};
+
+static std::array<Entry, kSlots> entries;
+static float angleStep;
+static float distanceStep;
+static uint64_t use;
+
+static CameraKey GetKey(float pitch, float yaw, float distance)
+{
+    return {int32_t(std::lround(pitch / angleStep)), int32_t(std::lround(yaw / angleStep)),
+        int32_t(std::lround(distance / distanceStep))};
+}
+
+bool InitPrefetch(SDL_GPUDevice* device, uint32_t width, uint32_t height, float angleStep, float distanceStep)
+{
+    ::angleStep = angleStep;
+    ::distanceStep = distanceStep;
+    for (Entry& entry : entries)
+    {
+        SDL_GPUTextureCreateInfo info{};
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.usage = SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.width = width;
+        info.height = height;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        entry.Texture = SDL_CreateGPUTexture(device, &info);
+        if (!entry.Texture)
+        {
+            SDL_Log("Failed to create texture: %s", SDL_GetError());
+            return false;
+        }
+    }
+    return true;
+}
+
+void QuitPrefetch(SDL_GPUDevice* device)
+{
+    for (Entry& entry : entries)
+    {
+        SDL_ReleaseGPUTexture(device, entry.Texture);
+        entry = {};
+    }
+}
+
+void ClearPrefetch()
+{
+    for (Entry& entry : entries)
+    {
+        entry.Valid = false;
+    }
+}
+
+SDL_GPUTexture* FindPrefetch(float pitch, float yaw, float distance, bool* exact)
+{
+    CameraKey key = GetKey(pitch, yaw, distance);
+    for (Entry& entry : entries)
+    {
+        if (entry.Valid && entry.Key == key)
+        {
+            entry.Use = ++use;
+            *exact = entry.Pitch == pitch && entry.Yaw == yaw && entry.Distance == distance && !entry.Truncated;
+            return entry.Texture;
+        }
+    }
+    return nullptr;
+}
+
+SDL_GPUTexture* StorePrefetch(float pitch, float yaw, float distance)
+{
+    if (!entries[0].Texture)
+    {
+        return nullptr;
+    }
+    CameraKey key = GetKey(pitch, yaw, distance);
+    Entry* oldest = &entries[0];
+    for (Entry& entry : entries)
+    {
+        if (entry.Valid && entry.Key == key)
+        {
+            return nullptr;
+        }
+        if (!entry.Valid || (oldest->Valid && entry.Use < oldest->Use))
+        {
+            oldest = &entry;
+        }
+    }
+    oldest->Valid = true;
+    oldest->Key = key;
+    oldest->Pitch = pitch;
+    oldest->Yaw = yaw;
+    oldest->Distance = distance;
+    oldest->Truncated = false;
+    oldest->Use = ++use;
+    return oldest->Texture;
+}
+
+void SetPrefetchTruncated(SDL_GPUTexture* texture)
+{
+    for (Entry& entry : entries)
+    {
+        if (entry.Texture == texture)
+        {
+            entry.Truncated = true;
+        }
+    }
+}
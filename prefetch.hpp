@@ -0,0 +1,20 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+
+/* NOTE: finished frames for camera states nobody asked for yet, keyed by the camera quantized to
+ * angleStep and distanceStep and evicted least recently used first */
+bool InitPrefetch(SDL_GPUDevice* device, uint32_t width, uint32_t height, float angleStep, float distanceStep);
+void QuitPrefetch(SDL_GPUDevice* device);
+void ClearPrefetch();
+
+/* NOTE: exact is set to whether the frame was rendered for exactly this camera with every ray finished */
+SDL_GPUTexture* FindPrefetch(float pitch, float yaw, float distance, bool* exact);
+
+/* NOTE: the texture to render the camera into, null if it's already cached */
+SDL_GPUTexture* StorePrefetch(float pitch, float yaw, float distance);
+
+/* NOTE: flags a stored frame whose rays ran out of steps so a hit on it is refined like a nearby one */
+void SetPrefetchTruncated(SDL_GPUTexture* texture);
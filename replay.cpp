@@ -0,0 +1,168 @@
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "replay.hpp"
+
+static constexpr char kMagic[4] = {'B', 'H', 'R', 'P'};
+static constexpr uint32_t kVersion = 1;
+
+/* NOTE: stored as raw floats so replayed camera math is bit-identical */
+struct ReplayEvent
+{
+    uint64_t Frame;
+    uint64_t Time;
+    uint32_t Type;
+    uint32_t State;
+    float X;
+    float Y;
+};
+
+static std::ofstream recordFile;
+static uint64_t recordStart;
+static std::vector<ReplayEvent> replayEvents;
+static size_t replayIndex;
+static uint64_t replayStart;
+static ReplayTiming replayTiming;
+static bool replaying;
+
+bool BeginRecording(const std::string_view& path)
+{
+    recordFile.open(std::string(path), std::ios::binary);
+    if (recordFile.fail())
+    {
+        SDL_Log("Failed to open recording: %s", std::string(path).data());
+        return false;
+    }
+    recordFile.write(kMagic, sizeof(kMagic));
+    recordFile.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+    recordStart = SDL_GetTicksNS();
+    return true;
+}
+
+void RecordEvent(uint64_t frame, const SDL_Event& event)
+{
+    if (!recordFile.is_open())
+    {
+        return;
+    }
+    ReplayEvent replayEvent{};
+    replayEvent.Frame = frame;
+    replayEvent.Type = event.type;
+    switch (event.type)
+    {
+    case SDL_EVENT_MOUSE_WHEEL:
+        replayEvent.X = event.wheel.x;
+        replayEvent.Y = event.wheel.y;
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        if (!(event.motion.state & SDL_BUTTON_LMASK))
+        {
+            return;
+        }
+        replayEvent.State = event.motion.state;
+        replayEvent.X = event.motion.xrel;
+        replayEvent.Y = event.motion.yrel;
+        break;
+    default:
+        return;
+    }
+    if (event.common.timestamp > recordStart)
+    {
+        replayEvent.Time = event.common.timestamp - recordStart;
+    }
+    recordFile.write(reinterpret_cast<const char*>(&replayEvent), sizeof(replayEvent));
+}
+
+void EndRecording()
+{
+    if (recordFile.is_open())
+    {
+        recordFile.close();
+    }
+}
+
+bool BeginReplay(const std::string_view& path, ReplayTiming timing)
+{
+    std::ifstream file(std::string(path), std::ios::binary);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open replay: %s", std::string(path).data());
+        return false;
+    }
+    char magic[4];
+    uint32_t version;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (file.fail() || std::memcmp(magic, kMagic, sizeof(kMagic)) || version != kVersion)
+    {
+        SDL_Log("Failed to parse replay: %s", std::string(path).data());
+        return false;
+    }
+    ReplayEvent replayEvent;
+    while (file.read(reinterpret_cast<char*>(&replayEvent), sizeof(replayEvent)))
+    {
+        replayEvents.push_back(replayEvent);
+    }
+    SDL_Log("Loaded replay: %s, %zu events", std::string(path).data(), replayEvents.size());
+    replayIndex = 0;
+    replayStart = SDL_GetTicksNS();
+    replayTiming = timing;
+    replaying = true;
+    return true;
+}
+
+bool PollReplay(uint64_t frame, SDL_Event* event)
+{
+    if (!replaying || replayIndex >= replayEvents.size())
+    {
+        return false;
+    }
+    const ReplayEvent& replayEvent = replayEvents[replayIndex];
+    if (replayTiming == ReplayTiming::Fixed && replayEvent.Frame > frame)
+    {
+        return false;
+    }
+    if (replayTiming == ReplayTiming::Original && replayEvent.Time > SDL_GetTicksNS() - replayStart)
+    {
+        return false;
+    }
+    replayIndex++;
+    SDL_zerop(event);
+    event->type = replayEvent.Type;
+    event->common.timestamp = replayStart + replayEvent.Time;
+    switch (replayEvent.Type)
+    {
+    case SDL_EVENT_MOUSE_WHEEL:
+        event->wheel.x = replayEvent.X;
+        event->wheel.y = replayEvent.Y;
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        event->motion.state = replayEvent.State;
+        event->motion.xrel = replayEvent.X;
+        event->motion.yrel = replayEvent.Y;
+        break;
+    }
+    return true;
+}
+
+bool IsReplaying()
+{
+    return replaying;
+}
+
+bool IsReplayFinished()
+{
+    return replaying && replayIndex >= replayEvents.size();
+}
+
+void EndReplay()
+{
+    replayEvents.clear();
+    replaying = false;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+#include <string_view>
+
+enum class ReplayTiming
+{
+    Fixed,
+    Original,
+};
+
+bool BeginRecording(const std::string_view& path);
+void RecordEvent(uint64_t frame, const SDL_Event& event);
+void EndRecording();
+bool BeginReplay(const std::string_view& path, ReplayTiming timing);
+bool PollReplay(uint64_t frame, SDL_Event* event);
+bool IsReplaying();
+bool IsReplayFinished();
+void EndReplay();
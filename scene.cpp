@@ -0,0 +1,252 @@
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(SDL_PLATFORM_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "json.hpp"
+#include "scene.hpp"
+
+static constexpr char kMagic[4] = {'B', 'H', 'S', 'C'};
+static constexpr uint32_t kVersion = 1;
+static constexpr uint32_t kRandomKinds = 16;
+
+struct SceneHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint32_t Count;
+    uint32_t Stride;
+};
+
+static_assert(sizeof(Object) == 32);
+static_assert(sizeof(SceneHeader) % alignof(Object) == 0);
+
+std::vector<Object> CreateDefaultScene()
+{
+    std::vector<Object> objects;
+    objects.push_back({{4e11f, 0.0f, 0.0f}, 4e10f, {1, 1, 0}, 1.98892e30f});
+    objects.push_back({{0.0f, 0.0f, 4e11f}, 4e10f, {1, 0, 0}, 1.98892e30f});
+    objects.push_back({{0.0f, 0.0f, 0.0f}, kBlackHoleRadius, {0, 0, 0}, kBlackHoleMass});
+    return objects;
+}
+
+std::vector<Object> CreateRandomScene(uint32_t count, uint32_t seed)
+{
+    /* NOTE: a thick disk of small bodies around the hole for stress testing */
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    /* NOTE: bodies come in a few kinds so they share prototypes once instanced */
+    std::vector<Object> kinds(kRandomKinds);
+    for (Object& kind : kinds)
+    {
+        kind.Radius = glm::mix(1.0e9f, 8.0e9f, unit(random));
+        kind.Color = glm::vec3(glm::mix(0.5f, 1.0f, unit(random)), glm::mix(0.3f, 1.0f, unit(random)), glm::mix(0.2f, 1.0f, unit(random)));
+        kind.Mass = glm::mix(1.0e29f, 4.0e30f, unit(random));
+    }
+    std::vector<Object> objects;
+    objects.reserve(count + 1);
+    objects.push_back({{0.0f, 0.0f, 0.0f}, kBlackHoleRadius, {0, 0, 0}, kBlackHoleMass});
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float r = glm::mix(kDiskR2 * 2.0f, kDiskR2 * 40.0f, std::sqrt(unit(random)));
+        float phi = unit(random) * glm::two_pi<float>();
+        float y = (unit(random) - 0.5f) * r * 0.1f;
+        Object object = kinds[std::min<uint32_t>(unit(random) * kRandomKinds, kRandomKinds - 1)];
+        object.Position = glm::vec3(r * std::cos(phi), y, r * std::sin(phi));
+        objects.push_back(object);
+    }
+    return objects;
+}
+
+Scene::~Scene()
+{
+    Unmap();
+}
+
+bool Scene::Load(const std::string_view& path)
+{
+    if (path.ends_with(".json"))
+    {
+        return LoadJson(path);
+    }
+    return LoadBinary(path);
+}
+
+void Scene::Load(std::vector<Object>&& objects)
+{
+    Unmap();
+    storage = std::move(objects);
+    this->objects = storage;
+}
+
+std::span<const Object> Scene::GetObjects() const
+{
+    return objects;
+}
+
+bool Scene::LoadJson(const std::string_view& path)
+{
+    std::ifstream file(std::string(path), std::ios::binary);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open scene: %s", std::string(path).data());
+        return false;
+    }
+    std::vector<Object> objects;
+    try
+    {
+        nlohmann::json json;
+        file >> json;
+        for (const nlohmann::json& entry : json["objects"])
+        {
+            Object object;
+            object.Position = glm::vec3(entry["position"][0], entry["position"][1], entry["position"][2]);
+            object.Radius = entry["radius"];
+            object.Color = glm::vec3(entry["color"][0], entry["color"][1], entry["color"][2]);
+            object.Mass = entry.value("mass", 0.0f);
+            objects.push_back(object);
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        SDL_Log("Failed to parse scene: %s, %s", std::string(path).data(), exception.what());
+        return false;
+    }
+    Load(std::move(objects));
+    return true;
+}
+
+bool Scene::LoadBinary(const std::string_view& path)
+{
+    Unmap();
+    std::string name(path);
+#if defined(SDL_PLATFORM_WIN32)
+    HANDLE file = CreateFileA(name.data(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        SDL_Log("Failed to open scene: %s", name.data());
+        return false;
+    }
+    fileHandle = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        SDL_Log("Failed to stat scene: %s", name.data());
+        Unmap();
+        return false;
+    }
+    mappingSize = size.QuadPart;
+    if (mappingSize >= sizeof(SceneHeader))
+    {
+        mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle)
+        {
+            mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+        }
+    }
+#else
+    int file = open(name.data(), O_RDONLY);
+    if (file < 0)
+    {
+        SDL_Log("Failed to open scene: %s", name.data());
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) == 0 && size_t(status.st_size) >= sizeof(SceneHeader))
+    {
+        mappingSize = status.st_size;
+        mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED)
+        {
+            mapping = nullptr;
+        }
+    }
+    close(file);
+#endif
+    if (!mapping)
+    {
+        SDL_Log("Failed to map scene: %s", name.data());
+        Unmap();
+        return false;
+    }
+    const SceneHeader* header = static_cast<const SceneHeader*>(mapping);
+    if (std::memcmp(header->Magic, kMagic, sizeof(kMagic)) || header->Version != kVersion ||
+        header->Stride != sizeof(Object) || sizeof(SceneHeader) + uint64_t(header->Count) * sizeof(Object) > mappingSize)
+    {
+        SDL_Log("Failed to parse scene: %s", name.data());
+        Unmap();
+        return false;
+    }
+    const Object* data = reinterpret_cast<const Object*>(header + 1);
+    storage.clear();
+    objects = std::span<const Object>(data, header->Count);
+    return true;
+}
+
+void Scene::Unmap()
+{
+#if defined(SDL_PLATFORM_WIN32)
+    if (mapping)
+    {
+        UnmapViewOfFile(mapping);
+    }
+    if (mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle)
+    {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (mapping)
+    {
+        munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    objects = storage;
+}
+
+bool SaveScene(const std::string_view& path, std::span<const Object> objects)
+{
+    std::ofstream file(std::string(path), std::ios::binary);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open scene: %s", std::string(path).data());
+        return false;
+    }
+    SceneHeader header{};
+    std::memcpy(header.Magic, kMagic, sizeof(kMagic));
+    header.Version = kVersion;
+    header.Count = objects.size();
+    header.Stride = sizeof(Object);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(objects.data()), objects.size_bytes());
+    return !file.fail();
+}
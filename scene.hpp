@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+static constexpr float kC = 299792458.0f;
+static constexpr float kG = 6.67430e-11f;
+static constexpr float kBlackHoleMass = 8.54e36f;
+static constexpr float kBlackHoleRadius = 2.0f * kG * kBlackHoleMass / (kC * kC);
+static constexpr float kDiskR1 = kBlackHoleRadius * 2.2f;
+static constexpr float kDiskR2 = kBlackHoleRadius * 5.2f;
+
+struct Object
+{
+    glm::vec3 Position;
+    float Radius;
+    glm::vec3 Color;
+    float Mass;
+};
+
+std::vector<Object> CreateDefaultScene();
+std::vector<Object> CreateRandomScene(uint32_t count, uint32_t seed);
+
+/* NOTE: json scenes are parsed into memory while binary scenes are mapped and read in place */
+class Scene
+{
+public:
+    Scene() = default;
+    ~Scene();
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+    bool Load(const std::string_view& path);
+    void Load(std::vector<Object>&& objects);
+    std::span<const Object> GetObjects() const;
+
+private:
+    bool LoadJson(const std::string_view& path);
+    bool LoadBinary(const std::string_view& path);
+    void Unmap();
+
+    std::vector<Object> storage;
+    std::span<const Object> objects;
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+};
+
+bool SaveScene(const std::string_view& path, std::span<const Object> objects);
@@ -12,7 +12,7 @@
 #include "json.hpp"
 #include "shader.hpp"
 
-static void* Load(SDL_GPUDevice* device, const std::string_view& name)
+static void* Load(SDL_GPUDevice* device, const std::string_view& name, const ComputeBindings* bindings)
 {
     SDL_GPUShaderFormat shaderFormat = SDL_GetGPUShaderFormats(device);
     const char* entrypoint;
@@ -77,6 +77,16 @@ static void* Load(SDL_GPUDevice* device, const std::string_view& name)
         info.threadcount_x = json["threadcount_x"];
         info.threadcount_y = json["threadcount_y"];
         info.threadcount_z = json["threadcount_z"];
+        if (info.num_samplers != bindings->Samplers ||
+            info.num_readonly_storage_textures != bindings->ReadonlyStorageTextures ||
+            info.num_readonly_storage_buffers != bindings->ReadonlyStorageBuffers ||
+            info.num_readwrite_storage_textures != bindings->ReadwriteStorageTextures ||
+            info.num_readwrite_storage_buffers != bindings->ReadwriteStorageBuffers ||
+            info.num_uniform_buffers != bindings->UniformBuffers)
+        {
+            SDL_Log("Shader is out of date: %s, regenerate bin with shadercross", jsonPath.data());
+            return nullptr;
+        }
         info.code = reinterpret_cast<Uint8*>(shaderData.data());
         info.code_size = shaderData.size();
         info.entrypoint = entrypoint;
@@ -114,10 +124,10 @@ static void* Load(SDL_GPUDevice* device, const std::string_view& name)
 
 SDL_GPUShader* LoadShader(SDL_GPUDevice* device, const std::string_view& name)
 {
-    return static_cast<SDL_GPUShader*>(Load(device, name));
+    return static_cast<SDL_GPUShader*>(Load(device, name, nullptr));
 }
 
-SDL_GPUComputePipeline* LoadComputePipeline(SDL_GPUDevice* device, const std::string_view& name)
+SDL_GPUComputePipeline* LoadComputePipeline(SDL_GPUDevice* device, const std::string_view& name, const ComputeBindings& bindings)
 {
-    return static_cast<SDL_GPUComputePipeline*>(Load(device, name));
+    return static_cast<SDL_GPUComputePipeline*>(Load(device, name, &bindings));
 }
\ No newline at end of file
@@ -2,7 +2,19 @@
 
 #include <SDL3/SDL.h>
 
+#include <cstdint>
 #include <string_view>
 
+/* NOTE: what the caller binds, checked against the reflection so binaries older than the source fail to load */
+struct ComputeBindings
+{
+    uint32_t Samplers;
+    uint32_t ReadonlyStorageTextures;
+    uint32_t ReadonlyStorageBuffers;
+    uint32_t ReadwriteStorageTextures;
+    uint32_t ReadwriteStorageBuffers;
+    uint32_t UniformBuffers;
+};
+
 SDL_GPUShader* LoadShader(SDL_GPUDevice* device, const std::string_view& name);
-SDL_GPUComputePipeline* LoadComputePipeline(SDL_GPUDevice* device, const std::string_view& name);
\ No newline at end of file
+SDL_GPUComputePipeline* LoadComputePipeline(SDL_GPUDevice* device, const std::string_view& name, const ComputeBindings& bindings);
\ No newline at end of file
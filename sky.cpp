@@ -0,0 +1,166 @@
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config.h"
+#include "sky.hpp"
+
+static glm::vec3 GetDirection(float ra, float dec)
+{
+    return glm::vec3(std::cos(dec) * std::cos(ra), std::sin(dec), std::cos(dec) * std::sin(ra));
+}
+
+static uint32_t GetCell(const glm::vec3& direction)
+{
+    float phi = std::atan2(direction.z, direction.x);
+    uint32_t z = std::min(uint32_t((direction.y + 1.0f) * 0.5f * SKY_ZS), uint32_t(SKY_ZS - 1));
+    uint32_t p = std::min(uint32_t((phi + glm::pi<float>()) / glm::two_pi<float>() * SKY_PHIS), uint32_t(SKY_PHIS - 1));
+    return z * SKY_PHIS + p;
+}
+
+static uint32_t EncodeDirection(const glm::vec3& direction)
+{
+    float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    float x = direction.x / sum;
+    float y = direction.y / sum;
+    if (direction.z < 0.0f)
+    {
+        float fold = 1.0f - std::abs(y);
+        y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fold * (x >= 0.0f ? 1.0f : -1.0f);
+    }
+    uint32_t u = uint32_t(std::clamp(x * 0.5f + 0.5f, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    uint32_t v = uint32_t(std::clamp(y * 0.5f + 0.5f, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    return u | (v << 16);
+}
+
+bool LoadCatalog(const std::string_view& path, std::vector<CatalogStar>& stars)
+{
+    /* NOTE: one "ra,dec,magnitude" line per star in degrees, lines that don't parse (headers) are skipped */
+    std::ifstream file(std::string(path), std::ios::binary);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open catalog: %s", std::string(path).data());
+        return false;
+    }
+    stars.clear();
+    std::string line;
+    while (std::getline(file, line))
+    {
+        float ra;
+        float dec;
+        float magnitude;
+        if (std::sscanf(line.data(), "%f,%f,%f", &ra, &dec, &magnitude) != 3)
+        {
+            continue;
+        }
+        glm::vec3 direction = GetDirection(glm::radians(ra), glm::radians(dec));
+        stars.emplace_back(direction, std::pow(10.0f, -0.4f * magnitude));
+    }
+    if (stars.empty())
+    {
+        SDL_Log("Failed to parse catalog: %s", std::string(path).data());
+        return false;
+    }
+    return true;
+}
+
+std::vector<CatalogStar> CreateRandomCatalog(uint32_t count, uint32_t seed)
+{
+    /* NOTE: star counts grow roughly as 10^(0.5m), sampled by inverting that between magnitude -1 and 12 */
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float min = std::pow(10.0f, 0.5f * -1.0f);
+    float max = std::pow(10.0f, 0.5f * 12.0f);
+    std::vector<CatalogStar> stars;
+    stars.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float y = unit(random) * 2.0f - 1.0f;
+        float phi = unit(random) * glm::two_pi<float>();
+        float s = std::sqrt(1.0f - y * y);
+        float magnitude = 2.0f * std::log10(glm::mix(min, max, unit(random)));
+        stars.emplace_back(glm::vec3(s * std::cos(phi), y, s * std::sin(phi)), std::pow(10.0f, -0.4f * magnitude));
+    }
+    return stars;
+}
+
+void BuildSky(std::span<const CatalogStar> stars, Sky& sky)
+{
+    /* NOTE: counting sort of the stars into cells */
+    sky.Cells.assign(SKY_ZS * SKY_PHIS, SkyCell{});
+    std::vector<uint32_t> cells(stars.size());
+    for (size_t i = 0; i < stars.size(); i++)
+    {
+        cells[i] = GetCell(glm::vec3(stars[i]));
+        sky.Cells[cells[i]].Count++;
+    }
+    uint32_t offset = 0;
+    for (SkyCell& cell : sky.Cells)
+    {
+        cell.Offset = offset;
+        offset += cell.Count;
+        cell.Count = 0;
+    }
+    sky.Stars.resize(stars.size());
+    for (size_t i = 0; i < stars.size(); i++)
+    {
+        SkyCell& cell = sky.Cells[cells[i]];
+        sky.Stars[cell.Offset + cell.Count++] = {EncodeDirection(glm::vec3(stars[i])), stars[i].w};
+    }
+    /* NOTE: flux per steradian, each level averages 2x2 cells of the one above since all cells have equal area */
+    float area = 4.0f * glm::pi<float>() / (SKY_ZS * SKY_PHIS);
+    sky.Map.resize(sky.Cells.size());
+    for (size_t i = 0; i < sky.Cells.size(); i++)
+    {
+        float flux = 0.0f;
+        for (uint32_t j = sky.Cells[i].Offset; j < sky.Cells[i].Offset + sky.Cells[i].Count; j++)
+        {
+            flux += sky.Stars[j].Flux;
+        }
+        sky.Map[i] = flux / area;
+    }
+    size_t source = 0;
+    for (int level = 1; level < SKY_LEVELS; level++)
+    {
+        uint32_t zs = SKY_ZS >> level;
+        uint32_t phis = SKY_PHIS >> level;
+        size_t destination = sky.Map.size();
+        sky.Map.resize(destination + zs * phis);
+        for (uint32_t z = 0; z < zs; z++)
+        {
+            for (uint32_t p = 0; p < phis; p++)
+            {
+                const float* row0 = &sky.Map[source + (z * 2) * phis * 2];
+                const float* row1 = row0 + phis * 2;
+                sky.Map[destination + z * phis + p] = (row0[p * 2] + row0[p * 2 + 1] + row1[p * 2] + row1[p * 2 + 1]) * 0.25f;
+            }
+        }
+        source = destination;
+    }
+}
+
+void PackSky(const Sky& sky, std::vector<uint32_t>& words)
+{
+    /* NOTE: the map, the cells and the stars share one buffer since a compute stage only has 8 storage buffers,
+     * the map and the cells have fixed sizes so the shader finds each part without offsets */
+    words.resize(sky.Map.size() + sky.Cells.size() * 2 + sky.Stars.size() * 2);
+    uint32_t* word = words.data();
+    std::memcpy(word, sky.Map.data(), sky.Map.size() * sizeof(float));
+    word += sky.Map.size();
+    std::memcpy(word, sky.Cells.data(), sky.Cells.size() * sizeof(SkyCell));
+    word += sky.Cells.size() * 2;
+    std::memcpy(word, sky.Stars.data(), sky.Stars.size() * sizeof(SkyStar));
+}
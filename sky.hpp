@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/* NOTE: direction in xyz and flux relative to a magnitude 0 star in w */
+using CatalogStar = glm::vec4;
+
+struct SkyCell
+{
+    uint32_t Offset;
+    uint32_t Count;
+};
+
+/* NOTE: octahedral encoded direction in 2x16 bits and flux */
+struct SkyStar
+{
+    uint32_t Direction;
+    float Flux;
+};
+
+/* NOTE: equal-area cells, uniform in y (the disk normal) and in longitude around it */
+struct Sky
+{
+    std::vector<float> Map;
+    std::vector<SkyCell> Cells;
+    std::vector<SkyStar> Stars;
+};
+
+bool LoadCatalog(const std::string_view& path, std::vector<CatalogStar>& stars);
+std::vector<CatalogStar> CreateRandomCatalog(uint32_t count, uint32_t seed);
+void BuildSky(std::span<const CatalogStar> stars, Sky& sky);
+void PackSky(const Sky& sky, std::vector<uint32_t>& words);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/* NOTE: single writer single reader triple buffer, the writer never blocks and the reader always takes
+ * the latest complete value, intermediate values it didn't get to are dropped */
+template <typename T>
+class Snapshot
+{
+public:
+    void Publish(const T& value)
+    {
+        slots[back] = value;
+        back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndex;
+        middle.notify_one();
+    }
+
+    /* NOTE: returns false and leaves value untouched if nothing was published since the last read */
+    bool Read(T& value)
+    {
+        if (!(middle.load(std::memory_order_relaxed) & kFresh))
+        {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndex;
+        value = slots[front];
+        return true;
+    }
+
+    /* NOTE: blocks until something is published after the last read */
+    void Wait()
+    {
+        uint32_t value = middle.load(std::memory_order_acquire);
+        while (!(value & kFresh))
+        {
+            middle.wait(value, std::memory_order_acquire);
+            value = middle.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+    static constexpr uint32_t kIndex = 3;
+    static constexpr uint32_t kFresh = 4;
+
+    std::array<T, 3> slots{};
+    std::atomic<uint32_t> middle{1};
+    uint32_t back = 0;
+    uint32_t front = 2;
+};
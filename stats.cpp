@@ -0,0 +1,184 @@
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+#include "stats.hpp"
+
+void FrameStats::Add(double ms)
+{
+    Samples.push_back(ms);
+}
+
+void FrameStats::Clear()
+{
+    Samples.clear();
+}
+
+size_t FrameStats::Count() const
+{
+    return Samples.size();
+}
+
+double FrameStats::Mean() const
+{
+    if (Samples.empty())
+    {
+        return 0.0;
+    }
+    return std::accumulate(Samples.begin(), Samples.end(), 0.0) / Samples.size();
+}
+
+double FrameStats::Stddev() const
+{
+    if (Samples.size() < 2)
+    {
+        return 0.0;
+    }
+    double mean = Mean();
+    double sum = 0.0;
+    for (double sample : Samples)
+    {
+        sum += (sample - mean) * (sample - mean);
+    }
+    return std::sqrt(sum / (Samples.size() - 1));
+}
+
+double FrameStats::Percentile(double p) const
+{
+    if (Samples.empty())
+    {
+        return 0.0;
+    }
+    std::vector<double> sorted = Samples;
+    std::sort(sorted.begin(), sorted.end());
+    double index = std::clamp(p, 0.0, 1.0) * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(index);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (index - lower);
+}
+
+double FrameStats::Max() const
+{
+    if (Samples.empty())
+    {
+        return 0.0;
+    }
+    return *std::max_element(Samples.begin(), Samples.end());
+}
+
+double FrameStats::Ci95() const
+{
+    if (Samples.size() < 2)
+    {
+        return 0.0;
+    }
+    return TCritical95(Samples.size() - 1.0) * Stddev() / std::sqrt(Samples.size());
+}
+
+std::vector<size_t> FrameStats::Histogram() const
+{
+    std::vector<size_t> histogram;
+    for (double sample : Samples)
+    {
+        size_t bucket = sample < 1.0 ? 0 : size_t(std::log2(sample)) + 1;
+        if (bucket >= histogram.size())
+        {
+            histogram.resize(bucket + 1);
+        }
+        histogram[bucket]++;
+    }
+    return histogram;
+}
+
+void FrameStats::Log(const char* name) const
+{
+    SDL_Log("%s: count=%zu mean=%.3fms p50=%.3fms p95=%.3fms p99=%.3fms max=%.3fms",
+        name, Count(), Mean(), Percentile(0.5), Percentile(0.95), Percentile(0.99), Max());
+}
+
+void FrameStats::LogHistogram(const char* name) const
+{
+    static constexpr size_t kWidth = 40;
+    std::vector<size_t> histogram = Histogram();
+    size_t peak = histogram.empty() ? 1 : *std::max_element(histogram.begin(), histogram.end());
+    for (size_t i = 0; i < histogram.size(); i++)
+    {
+        double lower = i ? std::ldexp(1.0, int(i) - 1) : 0.0;
+        std::string bar(histogram[i] * kWidth / peak, '#');
+        SDL_Log("%s: %5.0f - %5.0f ms %6zu %s", name, lower, std::ldexp(1.0, int(i)), histogram[i], bar.data());
+    }
+}
+
+double TCritical95(double df)
+{
+    /* NOTE: Cornish-Fisher expansion of the two-sided 95% Student t quantile */
+    static constexpr double z = 1.959964;
+    if (df <= 0.0)
+    {
+        return 0.0;
+    }
+    double z3 = z * z * z;
+    double z5 = z3 * z * z;
+    return z +
+        (z3 + z) / (4.0 * df) +
+        (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * df * df);
+}
+
+double WelchDf(double stddev1, size_t count1, double stddev2, size_t count2)
+{
+    if (count1 < 2 || count2 < 2)
+    {
+        return 0.0;
+    }
+    double a = stddev1 * stddev1 / count1;
+    double b = stddev2 * stddev2 / count2;
+    if (a + b <= 0.0)
+    {
+        return count1 + count2 - 2.0;
+    }
+    return (a + b) * (a + b) / (a * a / (count1 - 1) + b * b / (count2 - 1));
+}
+
+bool SaveStats(const std::string_view& path, const std::vector<std::pair<std::string, const FrameStats*>>& stats)
+{
+    nlohmann::json json;
+    for (const auto& [name, frameStats] : stats)
+    {
+        nlohmann::json& entry = json[name];
+        entry["count"] = frameStats->Count();
+        entry["mean"] = frameStats->Mean();
+        entry["stddev"] = frameStats->Stddev();
+        entry["p50"] = frameStats->Percentile(0.5);
+        entry["p95"] = frameStats->Percentile(0.95);
+        entry["p99"] = frameStats->Percentile(0.99);
+        entry["max"] = frameStats->Max();
+        entry["ci95"] = frameStats->Ci95();
+        entry["histogram"] = frameStats->Histogram();
+        entry["samples"] = frameStats->Samples;
+    }
+    std::ofstream file(std::string(path), std::ios::binary);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open stats: %s", std::string(path).data());
+        return false;
+    }
+    try
+    {
+        file << json.dump(4);
+    }
+    catch (const std::exception& exception)
+    {
+        SDL_Log("Failed to write stats: %s, %s", std::string(path).data(), exception.what());
+        return false;
+    }
+    return true;
+}
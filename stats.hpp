@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct FrameStats
+{
+    void Add(double ms);
+    void Clear();
+    size_t Count() const;
+    double Mean() const;
+    double Stddev() const;
+    double Percentile(double p) const;
+    double Max() const;
+    double Ci95() const;
+    /* NOTE: bucket 0 counts samples under 1ms and bucket i those in [2^(i - 1), 2^i) ms */
+    std::vector<size_t> Histogram() const;
+    void Log(const char* name) const;
+    void LogHistogram(const char* name) const;
+
+    std::vector<double> Samples;
+};
+
+double TCritical95(double df);
+double WelchDf(double stddev1, size_t count1, double stddev2, size_t count2);
+bool SaveStats(const std::string_view& path, const std::vector<std::pair<std::string, const FrameStats*>>& stats);
@@ -0,0 +1,130 @@
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "stream.hpp"
+
+static constexpr uint32_t kGap = 256;
+static constexpr size_t kMaxRanges = 64;
+
+bool StreamBuffer::Init(SDL_GPUDevice* device, SDL_GPUBuffer* buffer, std::span<const std::byte> data, uint32_t capacity, uint32_t stride)
+{
+    this->buffer = buffer;
+    this->capacity = std::max<uint32_t>(capacity, data.size());
+    this->stride = stride;
+    shadow.assign(data.begin(), data.end());
+    SDL_GPUTransferBufferCreateInfo info{};
+    info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    info.size = std::max(this->capacity, 16u);
+    transferBuffer = SDL_CreateGPUTransferBuffer(device, &info);
+    if (!transferBuffer)
+    {
+        SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void StreamBuffer::Quit(SDL_GPUDevice* device)
+{
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    transferBuffer = nullptr;
+}
+
+void StreamBuffer::FindRanges(std::span<const std::byte> data)
+{
+    /* NOTE: compares whole elements against the last upload and merges ranges separated by small gaps */
+    ranges.clear();
+    uint32_t size = std::min<uint32_t>(data.size(), shadow.size());
+    for (uint32_t offset = 0; offset < size; offset += stride)
+    {
+        uint32_t length = std::min(stride, size - offset);
+        if (!std::memcmp(data.data() + offset, shadow.data() + offset, length))
+        {
+            continue;
+        }
+        if (!ranges.empty() && offset - (ranges.back().Offset + ranges.back().Size) <= kGap)
+        {
+            ranges.back().Size = offset + length - ranges.back().Offset;
+        }
+        else
+        {
+            ranges.push_back({offset, length});
+        }
+    }
+    if (data.size() > size && !ranges.empty() && size - (ranges.back().Offset + ranges.back().Size) <= kGap)
+    {
+        ranges.back().Size = data.size() - ranges.back().Offset;
+    }
+    else if (data.size() > size)
+    {
+        ranges.push_back({size, uint32_t(data.size()) - size});
+    }
+    if (ranges.size() > kMaxRanges)
+    {
+        /* NOTE: one large copy beats many tiny ones */
+        uint32_t end = ranges.back().Offset + ranges.back().Size;
+        ranges = {{ranges.front().Offset, end - ranges.front().Offset}};
+    }
+}
+
+bool StreamBuffer::Upload(SDL_GPUDevice* device, SDL_GPUCopyPass* copyPass, std::span<const std::byte> data)
+{
+    uploadedBytes = 0;
+    if (data.size() > capacity)
+    {
+        SDL_Log("Failed to stream buffer: %zu bytes exceeds capacity %u", data.size(), capacity);
+        return false;
+    }
+    FindRanges(data);
+    shadow.assign(data.begin(), data.end());
+    if (ranges.empty())
+    {
+        return true;
+    }
+    /* NOTE: cycling hands back an idle transfer buffer so frames in flight are never waited on */
+    std::byte* mapped = static_cast<std::byte*>(SDL_MapGPUTransferBuffer(device, transferBuffer, true));
+    if (!mapped)
+    {
+        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+    uint32_t offset = 0;
+    for (const Range& range : ranges)
+    {
+        std::memcpy(mapped + offset, data.data() + range.Offset, range.Size);
+        offset += range.Size;
+    }
+    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    offset = 0;
+    for (const Range& range : ranges)
+    {
+        /* NOTE: the destination isn't cycled since the bytes outside the ranges must be kept */
+        SDL_GPUTransferBufferLocation location{};
+        SDL_GPUBufferRegion region{};
+        location.transfer_buffer = transferBuffer;
+        location.offset = offset;
+        region.buffer = buffer;
+        region.offset = range.Offset;
+        region.size = range.Size;
+        SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
+        offset += range.Size;
+    }
+    uploadedBytes = offset;
+    return true;
+}
+
+uint32_t StreamBuffer::GetUploadedBytes() const
+{
+    return uploadedBytes;
+}
+
+uint32_t StreamBuffer::GetUploadedRanges() const
+{
+    return ranges.size();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/* NOTE: uploads only the ranges of a storage buffer that changed since the last upload */
+class StreamBuffer
+{
+public:
+    bool Init(SDL_GPUDevice* device, SDL_GPUBuffer* buffer, std::span<const std::byte> data, uint32_t capacity, uint32_t stride);
+    void Quit(SDL_GPUDevice* device);
+    bool Upload(SDL_GPUDevice* device, SDL_GPUCopyPass* copyPass, std::span<const std::byte> data);
+    uint32_t GetUploadedBytes() const;
+    uint32_t GetUploadedRanges() const;
+
+private:
+    struct Range
+    {
+        uint32_t Offset;
+        uint32_t Size;
+    };
+
+    void FindRanges(std::span<const std::byte> data);
+
+    SDL_GPUBuffer* buffer = nullptr;
+    SDL_GPUTransferBuffer* transferBuffer = nullptr;
+    uint32_t capacity = 0;
+    uint32_t stride = 0;
+    std::vector<std::byte> shadow;
+    std::vector<Range> ranges;
+    uint32_t uploadedBytes = 0;
+};
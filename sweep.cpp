@@ -0,0 +1,290 @@
+#include <SDL3/SDL.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "json.hpp"
+#include "scene.hpp"
+#include "tracer.hpp"
+
+static constexpr int kClasses = static_cast<int>(PixelClass::Count);
+static constexpr const char* kClassNames[kClasses] = {"hole", "disk", "object", "sky"};
+
+struct SweepResult
+{
+    TracerSettings Settings;
+    std::string Name;
+    double StepsPerPixel;
+    double EvalsPerPixel;
+    double CpuMs;
+    double Rmse;
+    double Mismatch;
+    std::array<double, kClasses> ClassMismatch;
+    bool Pareto;
+};
+
+static int width = 64;
+static int height = 48;
+static const char* csvPath = "sweep.csv";
+static const char* jsonPath = "sweep.json";
+
+static bool ParseArgs(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        if (arg == "--width" && i + 1 < argc)
+        {
+            width = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--height" && i + 1 < argc)
+        {
+            height = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--csv" && i + 1 < argc)
+        {
+            csvPath = argv[++i];
+        }
+        else if (arg == "--json" && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else
+        {
+            SDL_Log("Unknown argument: %s", arg.data());
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string GetName(const TracerSettings& settings)
+{
+    return std::format("{}_l{:.0e}_g{}_s{}_e{:.0e}{}{}",
+        settings.Integrator == IntegratorType::Euler ? "euler" : "rk4",
+        settings.Lambda, settings.Growth, settings.Steps, settings.Escape,
+        settings.SkipObjects ? "_skip" : "",
+        settings.EscapeOutward ? "_outward" : "");
+}
+
+static std::vector<TracerSettings> GetSweepSettings()
+{
+    std::vector<TracerSettings> settings;
+    for (IntegratorType integrator : {IntegratorType::Euler, IntegratorType::Rk4})
+    {
+        for (double lambda : {1.0e7, 3.0e7, 1.0e8})
+        {
+            for (double growth : {0.0, 0.01, 0.05})
+            {
+                for (int steps : {20000, 60000})
+                {
+                    /* NOTE: 5e11 is just past the default scene, 1e30 is never reached */
+                    for (double escape : {1.0e30, 5.0e11})
+                    {
+                        for (bool skipObjects : {true, false})
+                        {
+                            for (bool escapeOutward : {false, true})
+                            {
+                                TracerSettings setting;
+                                setting.Integrator = integrator;
+                                setting.Lambda = lambda;
+                                setting.Growth = growth;
+                                setting.Steps = steps;
+                                setting.Escape = escape;
+                                setting.SkipObjects = skipObjects;
+                                setting.EscapeOutward = escapeOutward;
+                                settings.push_back(setting);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return settings;
+}
+
+static bool SaveCsv(const std::vector<SweepResult>& results)
+{
+    std::ofstream file(csvPath);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open csv: %s", csvPath);
+        return false;
+    }
+    file << "name,integrator,lambda,growth,steps,escape,skip_objects,escape_outward,"
+        "steps_per_pixel,evals_per_pixel,cpu_ms,rmse,mismatch";
+    for (const char* name : kClassNames)
+    {
+        file << ",mismatch_" << name;
+    }
+    file << ",pareto\n";
+    for (const SweepResult& result : results)
+    {
+        const TracerSettings& settings = result.Settings;
+        file << std::format("{},{},{},{},{},{},{},{},{},{},{},{},{}",
+            result.Name, settings.Integrator == IntegratorType::Euler ? "euler" : "rk4",
+            settings.Lambda, settings.Growth, settings.Steps, settings.Escape,
+            int(settings.SkipObjects), int(settings.EscapeOutward), result.StepsPerPixel,
+            result.EvalsPerPixel, result.CpuMs, result.Rmse, result.Mismatch);
+        for (double mismatch : result.ClassMismatch)
+        {
+            file << "," << mismatch;
+        }
+        file << "," << int(result.Pareto) << "\n";
+    }
+    return true;
+}
+
+static bool SaveJson(const TracerSettings& reference, const std::vector<SweepResult>& results)
+{
+    auto toJson = [](const TracerSettings& settings)
+    {
+        nlohmann::json json;
+        json["integrator"] = settings.Integrator == IntegratorType::Euler ? "euler" : "rk4";
+        json["lambda"] = settings.Lambda;
+        json["growth"] = settings.Growth;
+        json["steps"] = settings.Steps;
+        json["escape"] = settings.Escape;
+        json["skip_objects"] = settings.SkipObjects;
+        json["escape_outward"] = settings.EscapeOutward;
+        return json;
+    };
+    nlohmann::json json;
+    json["width"] = width;
+    json["height"] = height;
+    json["reference"] = toJson(reference);
+    json["pareto"] = nlohmann::json::array();
+    for (const SweepResult& result : results)
+    {
+        nlohmann::json entry;
+        entry["name"] = result.Name;
+        entry["settings"] = toJson(result.Settings);
+        entry["steps_per_pixel"] = result.StepsPerPixel;
+        entry["evals_per_pixel"] = result.EvalsPerPixel;
+        entry["cpu_ms"] = result.CpuMs;
+        entry["rmse"] = result.Rmse;
+        entry["mismatch"] = result.Mismatch;
+        for (int i = 0; i < kClasses; i++)
+        {
+            entry["class_mismatch"][kClassNames[i]] = result.ClassMismatch[i];
+        }
+        if (result.Pareto)
+        {
+            json["pareto"].push_back(entry);
+        }
+        json["configs"].push_back(entry);
+    }
+    std::ofstream file(jsonPath);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open json: %s", jsonPath);
+        return false;
+    }
+    file << json.dump(4);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (!ParseArgs(argc, argv))
+    {
+        return 1;
+    }
+    std::vector<Object> objects = CreateDefaultScene();
+    const std::vector<BenchmarkView>& views = GetBenchmarkViews();
+    /* NOTE: a fixed rk4 step ten times finer than the gpu's euler step everywhere, no step growth with distance */
+    TracerSettings reference;
+    reference.Integrator = IntegratorType::Rk4;
+    reference.Lambda = 1.0e6;
+    reference.Growth = 0.0;
+    reference.Steps = 100000000;
+    reference.SkipObjects = false;
+    reference.EscapeOutward = true;
+    std::vector<std::vector<TracerPixel>> references(views.size());
+    for (size_t i = 0; i < views.size(); i++)
+    {
+        SDL_Log("Rendering reference: %s", views[i].Name);
+        Trace(reference, views[i].Pitch, views[i].Yaw, views[i].Distance, objects, width, height, references[i]);
+    }
+    std::vector<SweepResult> results;
+    for (const TracerSettings& settings : GetSweepSettings())
+    {
+        SweepResult& result = results.emplace_back();
+        result.Settings = settings;
+        result.Name = GetName(settings);
+        uint64_t steps = 0;
+        double error = 0.0;
+        uint64_t mismatches = 0;
+        std::array<uint64_t, kClasses> classMismatches{};
+        std::array<uint64_t, kClasses> classCounts{};
+        uint64_t start = SDL_GetTicksNS();
+        std::vector<TracerPixel> pixels;
+        for (size_t i = 0; i < views.size(); i++)
+        {
+            Trace(settings, views[i].Pitch, views[i].Yaw, views[i].Distance, objects, width, height, pixels);
+            for (size_t j = 0; j < pixels.size(); j++)
+            {
+                const TracerPixel& pixel = pixels[j];
+                const TracerPixel& truth = references[i][j];
+                glm::vec3 delta = pixel.Color - truth.Color;
+                int truthClass = static_cast<int>(truth.Class);
+                steps += pixel.Steps;
+                error += glm::dot(delta, delta) / 3.0;
+                classCounts[truthClass]++;
+                if (pixel.Class != truth.Class)
+                {
+                    mismatches++;
+                    classMismatches[truthClass]++;
+                }
+            }
+        }
+        double pixelCount = double(views.size()) * width * height;
+        result.CpuMs = (SDL_GetTicksNS() - start) / 1.0e6;
+        result.StepsPerPixel = steps / pixelCount;
+        result.EvalsPerPixel = result.StepsPerPixel * (settings.Integrator == IntegratorType::Rk4 ? 4.0 : 1.0);
+        result.Rmse = std::sqrt(error / pixelCount);
+        result.Mismatch = mismatches / pixelCount;
+        for (int i = 0; i < kClasses; i++)
+        {
+            result.ClassMismatch[i] = classCounts[i] ? double(classMismatches[i]) / classCounts[i] : 0.0;
+        }
+        SDL_Log("%s: %.1f evals/px, rmse=%.4f, mismatch=%.4f, %.0fms",
+            result.Name.data(), result.EvalsPerPixel, result.Rmse, result.Mismatch, result.CpuMs);
+    }
+    for (SweepResult& result : results)
+    {
+        result.Pareto = std::none_of(results.begin(), results.end(), [&](const SweepResult& other)
+        {
+            return
+                other.EvalsPerPixel <= result.EvalsPerPixel && other.Rmse <= result.Rmse &&
+                (other.EvalsPerPixel < result.EvalsPerPixel || other.Rmse < result.Rmse);
+        });
+    }
+    std::sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b)
+    {
+        return a.EvalsPerPixel < b.EvalsPerPixel;
+    });
+    for (const SweepResult& result : results)
+    {
+        if (result.Pareto)
+        {
+            SDL_Log("Pareto: %s (%.1f evals/px, rmse=%.4f)", result.Name.data(), result.EvalsPerPixel, result.Rmse);
+        }
+    }
+    if (!SaveCsv(results) || !SaveJson(reference, results))
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <SDL3/SDL.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include "telemetry.hpp"
+
+static constexpr char kMagic[4] = {'B', 'H', 'T', 'L'};
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kCapacity = 4096;
+static constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+
+/* NOTE: single producer (render loop) and single consumer (writer thread), so head and tail are the only shared state */
+static std::array<TelemetryRecord, kCapacity> records;
+static std::atomic<size_t> head;
+static std::atomic<size_t> tail;
+static std::atomic<uint32_t> droppedRecords;
+static std::atomic<bool> running;
+static std::thread thread;
+static std::mutex mutex;
+static std::condition_variable condition;
+static std::string filePath;
+static TelemetryFormat fileFormat;
+static uint64_t fileMaxBytes;
+static int fileMaxCount;
+static std::ofstream file;
+static uint64_t fileBytes;
+
+static bool Open()
+{
+    file.open(filePath, std::ios::binary | std::ios::trunc);
+    if (file.fail())
+    {
+        SDL_Log("Failed to open telemetry: %s", filePath.data());
+        return false;
+    }
+    fileBytes = 0;
+    if (fileFormat == TelemetryFormat::Binary)
+    {
+        uint32_t size = sizeof(TelemetryRecord);
+        file.write(kMagic, sizeof(kMagic));
+        file.write(reinterpret_cast<const char*>(&kVersion), sizeof(kVersion));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        fileBytes += sizeof(kMagic) + sizeof(kVersion) + sizeof(size);
+    }
+    return true;
+}
+
+static void Rotate()
+{
+    file.close();
+    std::error_code error;
+    for (int i = fileMaxCount - 1; i > 0; i--)
+    {
+        std::string from = i == 1 ? filePath : std::format("{}.{}", filePath, i - 1);
+        std::string to = std::format("{}.{}", filePath, i);
+        std::filesystem::rename(from, to, error);
+    }
+    if (fileMaxCount <= 1)
+    {
+        std::filesystem::remove(filePath, error);
+    }
+    Open();
+}
+
+static void Write(const TelemetryRecord& record)
+{
+    if (fileFormat == TelemetryFormat::Binary)
+    {
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        fileBytes += sizeof(record);
+    }
+    else
+    {
+        std::string line = std::format(
+            "{{\"frame\":{},\"time\":{},\"frame_ms\":{:.3f},\"gpu_ms\":{:.3f},"
+            "\"pitch\":{:.4f},\"yaw\":{:.4f},\"distance\":{:.4e},"
+            "\"render\":[{},{}],\"window\":[{},{}],\"steps_per_pixel\":{:.1f},"
+            "\"dropped_frames\":{},\"dropped_records\":{}}}\n",
+            record.Frame, record.Time, record.FrameMs, record.GpuMs,
+            record.Pitch, record.Yaw, record.Distance,
+            record.RenderWidth, record.RenderHeight, record.WindowWidth, record.WindowHeight,
+            record.StepsPerPixel, record.DroppedFrames, record.DroppedRecords);
+        file.write(line.data(), line.size());
+        fileBytes += line.size();
+    }
+    if (fileBytes >= fileMaxBytes)
+    {
+        Rotate();
+    }
+}
+
+static void Run()
+{
+    while (true)
+    {
+        {
+            std::unique_lock lock(mutex);
+            condition.wait_for(lock, kFlushInterval);
+        }
+        bool stopping = !running;
+        size_t end = head.load(std::memory_order_acquire);
+        size_t begin = tail.load(std::memory_order_relaxed);
+        for (; begin != end; begin++)
+        {
+            if (file.is_open())
+            {
+                Write(records[begin % kCapacity]);
+            }
+        }
+        tail.store(begin, std::memory_order_release);
+        file.flush();
+        if (stopping)
+        {
+            break;
+        }
+    }
+}
+
+bool InitTelemetry(const std::string_view& path, TelemetryFormat format, uint64_t maxBytes, int maxFiles)
+{
+    filePath = path;
+    fileFormat = format;
+    fileMaxBytes = maxBytes;
+    fileMaxCount = maxFiles;
+    if (!Open())
+    {
+        return false;
+    }
+    running = true;
+    thread = std::thread(Run);
+    return true;
+}
+
+void WriteTelemetry(const TelemetryRecord& record)
+{
+    if (!running)
+    {
+        return;
+    }
+    size_t index = head.load(std::memory_order_relaxed);
+    if (index - tail.load(std::memory_order_acquire) >= kCapacity)
+    {
+        /* NOTE: never wait on the writer, drop the record and report it in the next one */
+        droppedRecords++;
+        return;
+    }
+    records[index % kCapacity] = record;
+    records[index % kCapacity].DroppedRecords = droppedRecords.exchange(0);
+    head.store(index + 1, std::memory_order_release);
+    if (index - tail.load(std::memory_order_relaxed) >= kCapacity / 2)
+    {
+        condition.notify_one();
+    }
+}
+
+void QuitTelemetry()
+{
+    if (!running)
+    {
+        return;
+    }
+    running = false;
+    condition.notify_one();
+    thread.join();
+    file.close();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+enum class TelemetryFormat
+{
+    Jsonl,
+    Binary,
+};
+
+struct TelemetryRecord
+{
+    uint64_t Frame;
+    uint64_t Time;
+    float FrameMs;
+    float GpuMs;
+    float Pitch;
+    float Yaw;
+    float Distance;
+    uint32_t RenderWidth;
+    uint32_t RenderHeight;
+    uint32_t WindowWidth;
+    uint32_t WindowHeight;
+    float StepsPerPixel;
+    uint32_t DroppedFrames;
+    uint32_t DroppedRecords;
+};
+
+bool InitTelemetry(const std::string_view& path, TelemetryFormat format, uint64_t maxBytes, int maxFiles);
+void WriteTelemetry(const TelemetryRecord& record);
+void QuitTelemetry();
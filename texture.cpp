@@ -0,0 +1,66 @@
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "texture.hpp"
+
+bool UploadTexture(SDL_GPUDevice* device, SDL_GPUTexture* texture, const void* pixels, uint32_t width, uint32_t height,
+    uint32_t pitch, bool mipmaps)
+{
+    SDL_GPUTransferBuffer* transferBuffer;
+    {
+        SDL_GPUTransferBufferCreateInfo info{};
+        info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        info.size = width * height * sizeof(uint32_t);
+        transferBuffer = SDL_CreateGPUTransferBuffer(device, &info);
+        if (!transferBuffer)
+        {
+            SDL_Log("Failed to create transfer buffer: %s", SDL_GetError());
+            return false;
+        }
+    }
+    uint8_t* data = static_cast<uint8_t*>(SDL_MapGPUTransferBuffer(device, transferBuffer, false));
+    if (!data)
+    {
+        SDL_Log("Failed to map transfer buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        return false;
+    }
+    for (uint32_t y = 0; y < height; y++)
+    {
+        std::memcpy(data + y * width * sizeof(uint32_t), static_cast<const uint8_t*>(pixels) + y * pitch, width * sizeof(uint32_t));
+    }
+    SDL_UnmapGPUTransferBuffer(device, transferBuffer);
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    if (!commandBuffer)
+    {
+        SDL_Log("Failed to acquire command buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        return false;
+    }
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    if (!copyPass)
+    {
+        SDL_Log("Failed to begin copy pass: %s", SDL_GetError());
+        SDL_CancelGPUCommandBuffer(commandBuffer);
+        SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+        return false;
+    }
+    SDL_GPUTextureTransferInfo info{};
+    SDL_GPUTextureRegion region{};
+    info.transfer_buffer = transferBuffer;
+    region.texture = texture;
+    region.w = width;
+    region.h = height;
+    region.d = 1;
+    SDL_UploadToGPUTexture(copyPass, &info, &region, false);
+    SDL_EndGPUCopyPass(copyPass);
+    if (mipmaps)
+    {
+        SDL_GenerateMipmapsForGPUTexture(commandBuffer, texture);
+    }
+    SDL_SubmitGPUCommandBuffer(commandBuffer);
+    SDL_ReleaseGPUTransferBuffer(device, transferBuffer);
+    return true;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+
+/* NOTE: blocking upload of rgba8 pixels into mip 0, optionally generating the rest of the chain */
+bool UploadTexture(SDL_GPUDevice* device, SDL_GPUTexture* texture, const void* pixels, uint32_t width, uint32_t height,
+    uint32_t pitch, bool mipmaps);
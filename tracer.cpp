@@ -0,0 +1,254 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "disk.hpp"
+#include "scene.hpp"
+#include "tracer.hpp"
+
+/* NOTE: a double precision port of geodesic.comp used as ground truth and for solver experiments */
+
+static constexpr double kRadius = kBlackHoleRadius;
+static constexpr double kFov = glm::radians(60.0);
+
+struct State
+{
+    double R;
+    double Theta;
+    double Phi;
+    double Dr;
+    double Dtheta;
+    double Dphi;
+};
+
+struct Ray
+{
+    State S;
+    double E;
+    glm::dvec3 Position;
+};
+
+/* NOTE: bilinear like the gpu sampler, repeating in angle and clamped in radius */
+static glm::vec3 SampleDisk(double u, double v)
+{
+    static const std::vector<uint32_t> pixels = []()
+    {
+        std::vector<uint32_t> pixels;
+        BakeDisk(pixels);
+        return pixels;
+    }();
+    auto texel = [](int x, int y)
+    {
+        x = (x % DISK_ANGLES + DISK_ANGLES) % DISK_ANGLES;
+        y = std::clamp(y, 0, DISK_RADII - 1);
+        uint32_t pixel = pixels[y * DISK_ANGLES + x];
+        return glm::vec3(pixel & 0xFF, (pixel >> 8) & 0xFF, (pixel >> 16) & 0xFF) / 255.0f;
+    };
+    double x = u * DISK_ANGLES - 0.5;
+    double y = v * DISK_RADII - 0.5;
+    int x0 = int(std::floor(x));
+    int y0 = int(std::floor(y));
+    float fx = float(x - x0);
+    float fy = float(y - y0);
+    glm::vec3 a = glm::mix(texel(x0, y0), texel(x0 + 1, y0), fx);
+    glm::vec3 b = glm::mix(texel(x0, y0 + 1), texel(x0 + 1, y0 + 1), fx);
+    return glm::mix(a, b, fy);
+}
+
+static glm::dvec3 ToCartesian(const State& s)
+{
+    return glm::dvec3(
+        s.R * std::sin(s.Theta) * std::cos(s.Phi),
+        s.R * std::sin(s.Theta) * std::sin(s.Phi),
+        s.R * std::cos(s.Theta));
+}
+
+static Ray CreateRay(const glm::dvec3& position, const glm::dvec3& direction)
+{
+    Ray ray;
+    State& s = ray.S;
+    ray.Position = position;
+    s.R = glm::length(position);
+    s.Theta = std::acos(position.z / s.R);
+    s.Phi = std::atan2(position.y, position.x);
+    double st = std::sin(s.Theta);
+    double ct = std::cos(s.Theta);
+    double sp = std::sin(s.Phi);
+    double cp = std::cos(s.Phi);
+    s.Dr = st * cp * direction.x + st * sp * direction.y + ct * direction.z;
+    s.Dtheta = (ct * cp * direction.x + ct * sp * direction.y - st * direction.z) / s.R;
+    s.Dphi = (-sp * direction.x + cp * direction.y) / (s.R * st);
+    double f = 1.0 - kRadius / s.R;
+    double dl = std::sqrt(s.Dr * s.Dr / f + s.R * s.R * (s.Dtheta * s.Dtheta + st * st * s.Dphi * s.Dphi));
+    ray.E = f * dl;
+    return ray;
+}
+
+static State Derivative(const State& s, double e)
+{
+    double r = s.R;
+    double st = std::sin(s.Theta);
+    double ct = std::cos(s.Theta);
+    double f = 1.0 - kRadius / r;
+    double dl = e / f;
+    State d;
+    d.R = s.Dr;
+    d.Theta = s.Dtheta;
+    d.Phi = s.Dphi;
+    d.Dr = -
+        (kRadius / (2.0 * r * r)) * f * dl * dl +
+        (kRadius / (2.0 * r * r * f)) * s.Dr * s.Dr +
+        r * (s.Dtheta * s.Dtheta + st * st * s.Dphi * s.Dphi);
+    d.Dtheta = -2.0 * s.Dr * s.Dtheta / r + st * ct * s.Dphi * s.Dphi;
+    d.Dphi = -2.0 * s.Dr * s.Dphi / r - 2.0 * ct / st * s.Dtheta * s.Dphi;
+    return d;
+}
+
+static State Add(const State& a, const State& b, double h)
+{
+    return State{
+        a.R + b.R * h,
+        a.Theta + b.Theta * h,
+        a.Phi + b.Phi * h,
+        a.Dr + b.Dr * h,
+        a.Dtheta + b.Dtheta * h,
+        a.Dphi + b.Dphi * h};
+}
+
+static void Step(const TracerSettings& settings, Ray& ray)
+{
+    double h = settings.Lambda;
+    if (settings.Growth > 0.0)
+    {
+        /* NOTE: lambda is the smallest step, far out it grows to this fraction of the distance to the horizon */
+        h = std::max(h, settings.Growth * (ray.S.R - kRadius));
+    }
+    if (settings.Integrator == IntegratorType::Euler)
+    {
+        ray.S = Add(ray.S, Derivative(ray.S, ray.E), h);
+    }
+    else
+    {
+        State k1 = Derivative(ray.S, ray.E);
+        State k2 = Derivative(Add(ray.S, k1, h * 0.5), ray.E);
+        State k3 = Derivative(Add(ray.S, k2, h * 0.5), ray.E);
+        State k4 = Derivative(Add(ray.S, k3, h), ray.E);
+        ray.S = Add(ray.S, k1, h / 6.0);
+        ray.S = Add(ray.S, k2, h / 3.0);
+        ray.S = Add(ray.S, k3, h / 3.0);
+        ray.S = Add(ray.S, k4, h / 6.0);
+    }
+    ray.Position = ToCartesian(ray.S);
+}
+
+static TracerPixel TracePixel(const TracerSettings& settings, const glm::dvec3& cameraPosition,
+    const glm::dvec3& direction, const std::vector<Object>& objects, double sceneRadius)
+{
+    TracerPixel pixel{glm::vec3(0.02f), PixelClass::Sky, 0};
+    Ray ray = CreateRay(cameraPosition, direction);
+    double nearest = 0.0;
+    for (int i = 0; i < settings.Steps; i++)
+    {
+        if (ray.S.R <= kRadius)
+        {
+            pixel.Color = glm::vec3(0.0f);
+            pixel.Class = PixelClass::Hole;
+            return pixel;
+        }
+        glm::dvec3 position = ray.Position;
+        Step(settings, ray);
+        pixel.Steps++;
+        nearest -= glm::distance(position, ray.Position);
+        double r = std::sqrt(ray.Position.x * ray.Position.x + ray.Position.z * ray.Position.z);
+        if (position.y * ray.Position.y < 0.0 && r >= kDiskR1 && r <= kDiskR2)
+        {
+            double angle = std::atan2(ray.Position.z, ray.Position.x);
+            pixel.Color = SampleDisk(angle / glm::two_pi<double>() + 0.5, (r - kDiskR1) / (kDiskR2 - kDiskR1));
+            pixel.Class = PixelClass::Disk;
+            return pixel;
+        }
+        if (nearest < 0.0 || !settings.SkipObjects)
+        {
+            nearest = settings.Escape;
+            for (const Object& object : objects)
+            {
+                glm::dvec3 center = glm::dvec3(object.Position);
+                double d = glm::distance(ray.Position, center) - object.Radius;
+                nearest = std::min(nearest, d);
+                if (d > 0.0)
+                {
+                    continue;
+                }
+                glm::dvec3 N = glm::normalize(ray.Position - center);
+                glm::dvec3 V = glm::normalize(cameraPosition - ray.Position);
+                double ambient = 0.1;
+                double intensity = ambient + (1.0 - ambient) * std::max(glm::dot(N, V), 0.0);
+                pixel.Color = object.Color * float(intensity);
+                pixel.Class = PixelClass::Object;
+                return pixel;
+            }
+        }
+        if (ray.S.R > settings.Escape)
+        {
+            break;
+        }
+        /* NOTE: outside the photon sphere and every object an outgoing ray can never come back */
+        if (settings.EscapeOutward && ray.S.Dr > 0.0 && ray.S.R > std::max({sceneRadius, 1.5 * kRadius, double(kDiskR2)}))
+        {
+            break;
+        }
+    }
+    return pixel;
+}
+
+void Trace(const TracerSettings& settings, float pitch, float yaw, float distance,
+    const std::vector<Object>& objects, int width, int height, std::vector<TracerPixel>& pixels)
+{
+    glm::dvec3 forward;
+    forward.x = std::cos(double(pitch)) * std::cos(double(yaw));
+    forward.y = std::sin(double(pitch));
+    forward.z = std::cos(double(pitch)) * std::sin(double(yaw));
+    forward = glm::normalize(forward);
+    glm::dvec3 position = -forward * double(distance);
+    glm::dvec3 right = glm::normalize(glm::cross(forward, glm::dvec3(0.0, 1.0, 0.0)));
+    glm::dvec3 up = glm::normalize(glm::cross(right, forward));
+    double tanHalfFov = std::tan(kFov * 0.5);
+    double aspect = double(width) / height;
+    double sceneRadius = 0.0;
+    for (const Object& object : objects)
+    {
+        sceneRadius = std::max(sceneRadius, glm::length(glm::dvec3(object.Position)) + object.Radius);
+    }
+    pixels.resize(width * height);
+    std::atomic<int> next = 0;
+    auto worker = [&]()
+    {
+        for (int y = next++; y < height; y = next++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                double u = (2.0 * (x + 0.5) / width - 1.0) * aspect * tanHalfFov;
+                double v = (1.0 - 2.0 * (y + 0.5) / height) * tanHalfFov;
+                glm::dvec3 direction = glm::normalize(u * right - v * up + forward);
+                pixels[y * width + x] = TracePixel(settings, position, direction, objects, sceneRadius);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < std::max(1u, std::thread::hardware_concurrency()); i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "scene.hpp"
+
+enum class IntegratorType
+{
+    Euler,
+    Rk4,
+};
+
+enum class PixelClass : uint8_t
+{
+    Hole,
+    Disk,
+    Object,
+    Sky,
+    Count,
+};
+
+/* NOTE: the defaults match geodesic.comp */
+struct TracerSettings
+{
+    double Lambda = 1.0e7;
+    double Growth = 0.0;
+    int Steps = 60000;
+    double Escape = 1.0e30;
+    IntegratorType Integrator = IntegratorType::Euler;
+    bool SkipObjects = true;
+    bool EscapeOutward = true;
+};
+
+struct TracerPixel
+{
+    glm::vec3 Color;
+    PixelClass Class;
+    uint32_t Steps;
+};
+
+void Trace(const TracerSettings& settings, float pitch, float yaw, float distance,
+    const std::vector<Object>& objects, int width, int height, std::vector<TracerPixel>& pixels);
@@ -0,0 +1,103 @@
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+
+#include "shader.hpp"
+#include "upscale.hpp"
+
+struct UniformBuffer
+{
+    float SourceSize[2];
+    float TargetSize[2];
+    SDL_FColor ClearColor;
+    uint32_t Filter;
+};
+
+static SDL_GPUGraphicsPipeline* pipeline;
+static SDL_GPUSampler* sampler;
+
+bool InitUpscale(SDL_GPUDevice* device, SDL_Window* window)
+{
+    SDL_GPUShader* vertexShader = LoadShader(device, "upscale.vert");
+    SDL_GPUShader* fragmentShader = LoadShader(device, "upscale.frag");
+    if (vertexShader && fragmentShader)
+    {
+        SDL_GPUColorTargetDescription target{};
+        target.format = SDL_GetGPUSwapchainTextureFormat(device, window);
+        SDL_GPUGraphicsPipelineCreateInfo info{};
+        info.vertex_shader = vertexShader;
+        info.fragment_shader = fragmentShader;
+        info.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+        info.target_info.color_target_descriptions = &target;
+        info.target_info.num_color_targets = 1;
+        pipeline = SDL_CreateGPUGraphicsPipeline(device, &info);
+        if (!pipeline)
+        {
+            SDL_Log("Failed to create pipeline: %s", SDL_GetError());
+        }
+    }
+    SDL_ReleaseGPUShader(device, vertexShader);
+    SDL_ReleaseGPUShader(device, fragmentShader);
+    if (!pipeline)
+    {
+        return false;
+    }
+    SDL_GPUSamplerCreateInfo info{};
+    info.min_filter = SDL_GPU_FILTER_LINEAR;
+    info.mag_filter = SDL_GPU_FILTER_LINEAR;
+    info.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
+    info.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+    info.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+    info.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+    sampler = SDL_CreateGPUSampler(device, &info);
+    if (!sampler)
+    {
+        SDL_Log("Failed to create sampler: %s", SDL_GetError());
+        SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+        pipeline = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void QuitUpscale(SDL_GPUDevice* device)
+{
+    SDL_ReleaseGPUSampler(device, sampler);
+    SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+}
+
+bool DrawUpscale(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTexture* source, uint32_t sourceWidth,
+    uint32_t sourceHeight, SDL_GPUTexture* target, uint32_t width, uint32_t height, uint32_t filter)
+{
+    if (!pipeline)
+    {
+        return false;
+    }
+    /* NOTE: every pixel is written by the fullscreen triangle so the old contents are never loaded */
+    SDL_GPUColorTargetInfo targetInfo{};
+    targetInfo.texture = target;
+    targetInfo.load_op = SDL_GPU_LOADOP_DONT_CARE;
+    targetInfo.store_op = SDL_GPU_STOREOP_STORE;
+    SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(commandBuffer, &targetInfo, 1, nullptr);
+    if (!renderPass)
+    {
+        SDL_Log("Failed to begin render pass: %s", SDL_GetError());
+        return false;
+    }
+    UniformBuffer uniformBuffer{};
+    uniformBuffer.SourceSize[0] = sourceWidth;
+    uniformBuffer.SourceSize[1] = sourceHeight;
+    uniformBuffer.TargetSize[0] = width;
+    uniformBuffer.TargetSize[1] = height;
+    uniformBuffer.ClearColor = {0.04f, 0.04f, 0.04f, 1.0f};
+    uniformBuffer.Filter = filter;
+    SDL_GPUTextureSamplerBinding binding{};
+    binding.texture = source;
+    binding.sampler = sampler;
+    SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
+    SDL_PushGPUFragmentUniformData(commandBuffer, 0, &uniformBuffer, sizeof(uniformBuffer));
+    SDL_BindGPUFragmentSamplers(renderPass, 0, &binding, 1);
+    SDL_DrawGPUPrimitives(renderPass, 3, 1, 0, 0);
+    SDL_EndGPURenderPass(renderPass);
+    return true;
+}
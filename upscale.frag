@@ -0,0 +1,62 @@
+#include "config.h"
+
+cbuffer UniformBuffer : register(b0, space3)
+{
+    float2 SourceSize;
+    float2 TargetSize;
+    float4 ClearColor;
+    uint Filter;
+};
+
+Texture2D<float4> source : register(t0, space2);
+SamplerState sourceSampler : register(s0, space2);
+
+/* NOTE: 4x4 catmull-rom folded into 9 bilinear taps by merging the two middle weights of each axis */
+float4 SampleCatmullRom(float2 uv)
+{
+    float2 position = uv * SourceSize;
+    float2 center = floor(position - 0.5f) + 0.5f;
+    float2 f = position - center;
+    float2 w0 = f * (-0.5f + f * (1.0f - 0.5f * f));
+    float2 w1 = 1.0f + f * f * (-2.5f + 1.5f * f);
+    float2 w2 = f * (0.5f + f * (2.0f - 1.5f * f));
+    float2 w3 = f * f * (-0.5f + 0.5f * f);
+    float2 w12 = w1 + w2;
+    float2 uv0 = (center - 1.0f) / SourceSize;
+    float2 uv12 = (center + w2 / w12) / SourceSize;
+    float2 uv3 = (center + 2.0f) / SourceSize;
+    float4 color = 0.0f;
+    color += source.SampleLevel(sourceSampler, float2(uv0.x, uv0.y), 0) * w0.x * w0.y;
+    color += source.SampleLevel(sourceSampler, float2(uv12.x, uv0.y), 0) * w12.x * w0.y;
+    color += source.SampleLevel(sourceSampler, float2(uv3.x, uv0.y), 0) * w3.x * w0.y;
+    color += source.SampleLevel(sourceSampler, float2(uv0.x, uv12.y), 0) * w0.x * w12.y;
+    color += source.SampleLevel(sourceSampler, float2(uv12.x, uv12.y), 0) * w12.x * w12.y;
+    color += source.SampleLevel(sourceSampler, float2(uv3.x, uv12.y), 0) * w3.x * w12.y;
+    color += source.SampleLevel(sourceSampler, float2(uv0.x, uv3.y), 0) * w0.x * w3.y;
+    color += source.SampleLevel(sourceSampler, float2(uv12.x, uv3.y), 0) * w12.x * w3.y;
+    color += source.SampleLevel(sourceSampler, float2(uv3.x, uv3.y), 0) * w3.x * w3.y;
+    /* NOTE: the negative lobes ring past the range of the neighbourhood */
+    return saturate(color);
+}
+
+float4 main(float4 position : SV_Position) : SV_Target0
+{
+    float scale = min(TargetSize.x / SourceSize.x, TargetSize.y / SourceSize.y);
+    float2 size = floor(SourceSize * scale);
+    float2 offset = floor((TargetSize - size) * 0.5f);
+    float2 uv = (position.xy - offset) / size;
+    if (any(uv < 0.0f) || any(uv >= 1.0f))
+    {
+        return ClearColor;
+    }
+    /* NOTE: the swapchain is always presented opaque whatever the source alpha holds */
+    if (Filter == UPSCALE_NEAREST)
+    {
+        return float4(source.Load(int3(uv * SourceSize, 0)).rgb, 1.0f);
+    }
+    if (Filter == UPSCALE_BILINEAR)
+    {
+        return float4(source.SampleLevel(sourceSampler, uv, 0).rgb, 1.0f);
+    }
+    return float4(SampleCatmullRom(uv).rgb, 1.0f);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <cstdint>
+
+/* NOTE: false leaves the module unavailable so callers keep their own copy to the swapchain */
+bool InitUpscale(SDL_GPUDevice* device, SDL_Window* window);
+void QuitUpscale(SDL_GPUDevice* device);
+
+/* NOTE: letterboxes, clears and filters source over the whole target in one render pass, filter is one
+ * of the UPSCALE_ defines, returns false without recording anything when the module is unavailable */
+bool DrawUpscale(SDL_GPUCommandBuffer* commandBuffer, SDL_GPUTexture* source, uint32_t sourceWidth,
+    uint32_t sourceHeight, SDL_GPUTexture* target, uint32_t width, uint32_t height, uint32_t filter);